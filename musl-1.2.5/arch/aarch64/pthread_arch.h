@@ -8,4 +8,8 @@ static inline uintptr_t __get_tp()
 #define TLS_ABOVE_TP
 #define GAP_ABOVE_TP 16
 
+#ifndef __AARCH64EB__
+#define RSEQ_SIG 0xd428bc00
+#endif
+
 #define MC_PC pc
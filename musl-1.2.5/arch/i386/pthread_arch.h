@@ -5,4 +5,6 @@ static inline uintptr_t __get_tp()
 	return tp;
 }
 
+#define RSEQ_SIG 0x53053053
+
 #define MC_PC gregs[REG_EIP]
@@ -13,4 +13,6 @@ static inline uintptr_t __get_tp()
 
 // the kernel calls the ip "nip", it's the first saved value after the 32
 // GPRs.
+#define RSEQ_SIG 0x0fe5000b
+
 #define MC_PC gp_regs[32]
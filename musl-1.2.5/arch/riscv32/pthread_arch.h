@@ -10,4 +10,6 @@ static inline uintptr_t __get_tp()
 
 #define DTP_OFFSET 0x800
 
+#define RSEQ_SIG 0xf1401073
+
 #define MC_PC __gregs[0]
@@ -9,4 +9,6 @@ static inline uintptr_t __get_tp()
 	return tp;
 }
 
+#define RSEQ_SIG 0xb2ff0fff
+
 #define MC_PC psw.addr
@@ -5,6 +5,8 @@ static inline uintptr_t __get_tp()
 	return tp;
 }
 
+#define RSEQ_SIG 0x53053053
+
 #define MC_PC gregs[REG_RIP]
 
 #define CANARY_PAD
@@ -44,7 +44,15 @@ struct r_debug {
 	ElfW(Addr) r_ldbase;
 };
 
+struct dl_phdr_snapshot {
+	unsigned long long int dlps_adds;
+	unsigned long long int dlps_subs;
+	size_t dlps_count;
+	const struct dl_phdr_info *dlps_info;
+};
+
 int dl_iterate_phdr(int (*)(struct dl_phdr_info *, size_t, void *), void *);
+const struct dl_phdr_snapshot *dl_phdr_snapshot_get(void);
 
 #ifdef __cplusplus
 }
@@ -37,6 +37,9 @@ extern "C" {
 #define PTHREAD_MUTEX_DEFAULT 0
 #define PTHREAD_MUTEX_RECURSIVE 1
 #define PTHREAD_MUTEX_ERRORCHECK 2
+#ifdef _GNU_SOURCE
+#define PTHREAD_MUTEX_ADAPTIVE_NP 3
+#endif
 
 #define PTHREAD_MUTEX_STALLED 0
 #define PTHREAD_MUTEX_ROBUST 1
@@ -54,6 +57,12 @@ extern "C" {
 #define PTHREAD_PROCESS_PRIVATE 0
 #define PTHREAD_PROCESS_SHARED 1
 
+#ifdef _GNU_SOURCE
+#define PTHREAD_RWLOCK_PREFER_READER_NP 0
+#define PTHREAD_RWLOCK_PREFER_WRITER_NP 1
+#define PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP 2
+#endif
+
 
 #define PTHREAD_MUTEX_INITIALIZER {{{0}}}
 #define PTHREAD_RWLOCK_INITIALIZER {{{0}}}
@@ -226,6 +235,16 @@ int pthread_getattr_default_np(pthread_attr_t *);
 int pthread_setattr_default_np(const pthread_attr_t *);
 int pthread_tryjoin_np(pthread_t, void **);
 int pthread_timedjoin_np(pthread_t, void **, const struct timespec *);
+int pthread_rwlockattr_setdistributed_np(pthread_rwlockattr_t *, int);
+int pthread_rwlockattr_getdistributed_np(const pthread_rwlockattr_t *__restrict, int *__restrict);
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t *, int);
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t *__restrict, int *__restrict);
+struct lockstat_np {
+	const volatile void *lock;
+	unsigned long long acquired, contended, wait_ns;
+};
+int pthread_lockstat_enable_np(int);
+size_t pthread_lockstat_np(struct lockstat_np *, size_t);
 #endif
 
 #if _REDIR_TIME64
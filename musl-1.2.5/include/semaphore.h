@@ -29,6 +29,10 @@ int    sem_trywait(sem_t *);
 int    sem_unlink(const char *);
 int    sem_wait(sem_t *);
 
+#ifdef _GNU_SOURCE
+int    sem_post_multiple(sem_t *, unsigned);
+#endif
+
 #if _REDIR_TIME64
 __REDIR(sem_timedwait, __sem_timedwait_time64);
 #endif
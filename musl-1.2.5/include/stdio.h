@@ -203,6 +203,16 @@ typedef struct _IO_cookie_io_functions_t {
 } cookie_io_functions_t;
 
 FILE *fopencookie(void *, const char *, cookie_io_functions_t);
+int fflushv(FILE *const *, size_t);
+ssize_t getdelim_slice(const char **__restrict, char **__restrict, size_t *__restrict, int, FILE *__restrict);
+ssize_t getline_slice(const char **__restrict, char **__restrict, size_t *__restrict, FILE *__restrict);
+size_t fsendfile(FILE *__restrict, FILE *__restrict, size_t);
+size_t fsendfile_fd(int, FILE *__restrict, size_t);
+
+struct printf_format;
+struct printf_format *printf_compile(const char *);
+int fprintf_compiled(FILE *__restrict, const struct printf_format *__restrict, ...);
+int vfprintf_compiled(FILE *__restrict, const struct printf_format *__restrict, __isoc_va_list);
 #endif
 
 #if defined(_LARGEFILE64_SOURCE)
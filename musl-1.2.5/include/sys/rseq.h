@@ -0,0 +1,22 @@
+#ifndef _SYS_RSEQ_H
+#define _SYS_RSEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __NEED_ptrdiff_t
+#include <bits/alltypes.h>
+
+/* Each thread's restartable sequences area is registered by libc and
+ * lies at __rseq_offset from the thread pointer. __rseq_size is zero
+ * if registration is unavailable. */
+extern const ptrdiff_t __rseq_offset;
+extern const unsigned int __rseq_size;
+extern const unsigned int __rseq_flags;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -17,6 +17,8 @@
 #include <pthread.h>
 #include <ctype.h>
 #include <dlfcn.h>
+#include <dirent.h>
+#include <time.h>
 #include <semaphore.h>
 #include <sys/membarrier.h>
 #include "pthread_impl.h"
@@ -82,12 +84,20 @@ struct dso {
 	size_t map_len;
 	dev_t dev;
 	ino_t ino;
+	off_t file_size;
+	struct timespec file_mtim;
 	char relocated;
 	char constructed;
 	char kernel_mapped;
 	char mark;
 	char bfs_built;
 	char runtime_loaded;
+	char tls_static;
+	char relative_done;
+	uint32_t bind_index;
+	struct sym_addr *volatile sym_addrs;
+	unsigned long long map_ns, reloc_ns, init_ns;
+	size_t nrelocs, nlookups;
 	struct dso **deps, *needed_by;
 	size_t ndeps_direct;
 	size_t next_dep;
@@ -119,6 +129,16 @@ struct symdef {
 	struct dso *dso;
 };
 
+struct sym_addr {
+	size_t addr;
+	Sym *sym;
+};
+
+struct addr_range {
+	size_t start, end;
+	struct dso *dso;
+};
+
 typedef void (*stage3_func)(size_t *, size_t *);
 
 static struct builtin_tls {
@@ -127,6 +147,8 @@ static struct builtin_tls {
 	void *space[16];
 } builtin_tls[1];
 #define MIN_TLS_ALIGN offsetof(struct builtin_tls, pt)
+#define TLS_SURPLUS 512
+#define TLS_SURPLUS_ALIGN 64
 
 #define ADDEND_LIMIT 4096
 static size_t *saved_addends, *apply_addends_to;
@@ -137,6 +159,7 @@ static char *env_path, *sys_path;
 static unsigned long long gencnt;
 static int runtime;
 static int ldd_mode;
+static int reloc_threads;
 static int ldso_fail;
 static int noload;
 static int shutting_down;
@@ -146,6 +169,7 @@ static struct debug debug;
 static struct tls_module *tls_tail;
 static size_t tls_cnt, tls_offset, tls_align = MIN_TLS_ALIGN;
 static size_t static_tls_cnt;
+static size_t surplus_offset, surplus_end, static_tls_align;
 static pthread_mutex_t init_fini_lock;
 static pthread_cond_t ctor_cond;
 static struct dso *builtin_deps[2];
@@ -153,6 +177,19 @@ static struct dso *const no_deps[1];
 static struct dso *builtin_ctor_queue[4];
 static struct dso **main_ctor_queue;
 static struct fdpic_loadmap *app_loadmap;
+static struct addr_range *addr_index;
+static size_t addr_index_cnt;
+static const struct dl_phdr_snapshot *volatile phdr_snapshot;
+static struct dl_phdr_info *phdr_info;
+static size_t phdr_info_cnt, phdr_info_size;
+static struct dso *addr_index_tail, *phdr_info_tail;
+static struct dso **dso_by_name, **dso_by_id;
+static size_t dso_index_mask, dso_index_cnt;
+static struct {
+	const char *out;
+	unsigned long long start, load, tls, reloc, entry, init;
+	size_t lookups;
+} stats;
 static struct fdpic_dummy_loadmap app_dummy_loadmap;
 
 struct debug *_dl_debug_addr = &debug;
@@ -345,6 +382,177 @@ static struct symdef find_sym(struct dso *dso, const char *s, int need_def)
 	return find_sym2(dso, s, need_def, 0);
 }
 
+/* While the initial set of DSOs is relocated the global lookup scope
+ * cannot change, so results of lookups from head are remembered by
+ * name. The table grows as needed and lookups just bypass it if that
+ * fails. */
+static struct sym_cache {
+	const char *name;
+	uint32_t h;
+	int need_def;
+	struct symdef def;
+} *sym_cache;
+static size_t sym_cache_mask, sym_cache_cnt;
+
+static struct sym_cache *sym_cache_slot(struct sym_cache *t, size_t mask,
+	const char *s, uint32_t h, int need_def)
+{
+	size_t i;
+	for (i=h; t[i&mask].name; i++)
+		if (t[i&mask].h == h && t[i&mask].need_def == need_def
+		    && !strcmp(t[i&mask].name, s))
+			break;
+	return t + (i&mask);
+}
+
+static int grow_sym_cache(void)
+{
+	size_t i, mask = 2*sym_cache_mask+1;
+	struct sym_cache *t = calloc(mask+1, sizeof *t), *e;
+	if (!t) return -1;
+	for (i=0; i<=sym_cache_mask; i++) {
+		e = sym_cache + i;
+		if (e->name) *sym_cache_slot(t, mask, e->name, e->h,
+			e->need_def) = *e;
+	}
+	free(sym_cache);
+	sym_cache = t;
+	sym_cache_mask = mask;
+	return 0;
+}
+
+static struct symdef find_sym_cached(const char *s, int need_def)
+{
+	uint32_t h = gnu_hash(s);
+	struct sym_cache *e = sym_cache_slot(sym_cache, sym_cache_mask,
+		s, h, need_def);
+	struct symdef def;
+
+	if (e->name) return e->def;
+	def = find_sym(head, s, need_def);
+	if (!def.sym) return def;
+	if (2*++sym_cache_cnt > sym_cache_mask) {
+		if (grow_sym_cache()) {
+			sym_cache_cnt--;
+			return def;
+		}
+		e = sym_cache_slot(sym_cache, sym_cache_mask, s, h, need_def);
+	}
+	*e = (struct sym_cache){ .name = s, .h = h, .need_def = need_def,
+		.def = def };
+	return def;
+}
+
+/* Startup statistics, enabled by LD_STATS, use the raw syscall since
+ * the vdso is not yet usable while the dynamic linker runs. */
+static unsigned long long stats_now(void)
+{
+	struct timespec ts = { 0 };
+#ifdef SYS_clock_gettime64
+	long ts32[2] = { 0 };
+	if (__syscall(SYS_clock_gettime64, CLOCK_MONOTONIC, &ts) == -ENOSYS
+	    && SYS_clock_gettime != SYS_clock_gettime64) {
+		__syscall(SYS_clock_gettime, CLOCK_MONOTONIC, ts32);
+		ts.tv_sec = ts32[0];
+		ts.tv_nsec = ts32[1];
+	}
+#else
+	__syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+#endif
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Opt-in cache of the symbol bindings made while relocating the
+ * initial set of DSOs, kept in the file named by LD_BIND_CACHE. It
+ * holds the identity of each DSO in load order, then for each lookup
+ * in relocation order the index of the symbol looked up and the
+ * indices of the DSO and symbol it resolved to. When every DSO
+ * matches, lookups are replayed from it after checking the name;
+ * on any mismatch they are done normally and the file rewritten. */
+#define BIND_CACHE_MAGIC 0x646e6962
+
+struct bind_cache_hdr {
+	uint32_t magic, ndso, nbind, pad;
+};
+
+static char *bind_cache_path;
+static struct bind_dso {
+	struct dso *dso;
+	size_t nsyms;
+	uint64_t id[5];
+} *bind_dsos;
+static size_t bind_ndso;
+static const uint32_t *bind_in;
+static void *bind_map;
+static size_t bind_map_len, bind_in_cnt, bind_pos;
+static uint32_t *bind_out;
+static size_t bind_out_cnt, bind_out_size;
+
+static int bind_grow(size_t n)
+{
+	uint32_t *b;
+	if (bind_out && n <= bind_out_size) return 0;
+	if (n < 2*bind_out_size) n = 2*bind_out_size;
+	if (n < 1024) n = 1024;
+	b = realloc(bind_out, 3*n*sizeof *b);
+	if (!b) {
+		free(bind_out);
+		bind_out = 0;
+		bind_out_cnt = bind_out_size = 0;
+		return -1;
+	}
+	bind_out = b;
+	bind_out_size = n;
+	return 0;
+}
+
+static void bind_record(uint32_t sym_index, struct symdef def)
+{
+	uint32_t *b;
+	if (bind_grow(bind_out_cnt+1)) return;
+	b = bind_out + 3*bind_out_cnt++;
+	b[0] = sym_index;
+	b[1] = def.sym ? def.dso->bind_index : -1;
+	b[2] = def.sym ? def.sym - def.dso->syms : 0;
+}
+
+/* Stop replaying, keeping the entries that matched so far as the
+ * start of the bindings to be written back. */
+static void bind_miss(void)
+{
+	const uint32_t *in = bind_in;
+	bind_in = 0;
+	if (bind_grow(bind_pos)) return;
+	memcpy(bind_out, in, 3*bind_pos*sizeof *bind_out);
+	bind_out_cnt = bind_pos;
+}
+
+static int bind_replay(uint32_t sym_index, const char *name, struct symdef *def)
+{
+	const uint32_t *b = bind_in + 3*bind_pos;
+	struct bind_dso *q;
+	Sym *sym;
+
+	if (bind_pos == bind_in_cnt || b[0] != sym_index) goto miss;
+	if (b[1] == -1) {
+		*def = (struct symdef){0};
+	} else {
+		if (b[1] >= bind_ndso) goto miss;
+		q = bind_dsos + b[1];
+		if (b[2] >= q->nsyms) goto miss;
+		sym = q->dso->syms + b[2];
+		if (sym->st_shndx == SHN_UNDEF
+		    || strcmp(name, q->dso->strings + sym->st_name))
+			goto miss;
+		*def = (struct symdef){ .sym = sym, .dso = q->dso };
+	}
+	bind_pos++;
+	return 1;
+miss:
+	bind_miss();
+	return 0;
+}
+
 static struct symdef get_lfs64(const char *name)
 {
 	const char *p;
@@ -395,6 +603,14 @@ static void do_relocs(struct dso *dso, size_t *rel, size_t rel_size, size_t stri
 	size_t tls_val;
 	size_t addend;
 	int skip_relative = 0, reuse_addends = 0, save_slot = 0;
+	int need_def;
+	/* Runs of relocations, such as the entries of a vtable or the
+	 * GOT and PLT slots for one function, often name the same symbol.
+	 * Remember recent lookups by symbol index. */
+	struct {
+		int index, need_def;
+		struct symdef def;
+	} recent[64] = {{0}}, *rc;
 
 	if (dso == &ldso) {
 		/* Only ldso's REL table needs addend saving/reuse. */
@@ -402,6 +618,7 @@ static void do_relocs(struct dso *dso, size_t *rel, size_t rel_size, size_t stri
 			reuse_addends = 1;
 		skip_relative = 1;
 	}
+	if (dso->relative_done) skip_relative = 1;
 
 	for (; rel_size; rel+=stride, rel_size-=stride*sizeof(size_t)) {
 		if (skip_relative && IS_RELATIVE(rel[1], dso->syms)) continue;
@@ -429,9 +646,27 @@ static void do_relocs(struct dso *dso, size_t *rel, size_t rel_size, size_t stri
 			sym = syms + sym_index;
 			name = strings + sym->st_name;
 			ctx = type==REL_COPY ? head->syms_next : head;
-			def = (sym->st_info>>4) == STB_LOCAL
-				? (struct symdef){ .dso = dso, .sym = sym }
-				: find_sym(ctx, name, type==REL_PLT);
+			need_def = type==REL_PLT;
+			rc = recent + sym_index % (sizeof recent / sizeof *recent);
+			if ((sym->st_info>>4) == STB_LOCAL) {
+				def = (struct symdef){ .dso = dso, .sym = sym };
+			} else if (type == REL_COPY) {
+				def = find_sym(ctx, name, need_def);
+				stats.lookups++;
+			} else if (rc->index == sym_index
+			    && rc->need_def == need_def) {
+				def = rc->def;
+			} else {
+				if (!bind_in || !bind_replay(sym_index, name, &def)) {
+					def = sym_cache ? find_sym_cached(name, need_def)
+						: find_sym(ctx, name, need_def);
+					stats.lookups++;
+					if (bind_out) bind_record(sym_index, def);
+				}
+				rc->index = sym_index;
+				rc->need_def = need_def;
+				rc->def = def;
+			}
 			if (!def.sym) def = get_lfs64(name);
 			if (!def.sym && (sym->st_shndx != SHN_UNDEF
 			    || sym->st_info>>4 != STB_WEAK)) {
@@ -457,7 +692,7 @@ static void do_relocs(struct dso *dso, size_t *rel, size_t rel_size, size_t stri
 		tls_val = def.sym ? def.sym->st_value : 0;
 
 		if ((type == REL_TPOFF || type == REL_TPOFF_NEG)
-		    && def.dso->tls_id > static_tls_cnt) {
+		    && def.dso->tls_id > static_tls_cnt && !def.dso->tls_static) {
 			error("Error relocating %s: %s: initial-exec TLS "
 				"resolves to dynamic definition in %s",
 				dso->name, name, def.dso->name);
@@ -518,7 +753,7 @@ static void do_relocs(struct dso *dso, size_t *rel, size_t rel_size, size_t stri
 #endif
 		case REL_TLSDESC:
 			if (stride<3) addend = reloc_addr[!TLSDESC_BACKWARDS];
-			if (def.dso->tls_id > static_tls_cnt) {
+			if (def.dso->tls_id > static_tls_cnt && !def.dso->tls_static) {
 				struct td_index *new = malloc(sizeof *new);
 				if (!new) {
 					error(
@@ -870,6 +1105,99 @@ error:
 	return 0;
 }
 
+/* Directories searched for libraries during one load operation. Once
+ * a directory is searched a second time, the hashes of the names in it
+ * are read in, so that names not present are skipped without a failed
+ * open per candidate. A hash match still just leads to an open. The
+ * lists are dropped at the end of each load operation so that files
+ * added later are found. */
+static struct dir_list {
+	struct dir_list *next;
+	uint32_t *tab;
+	size_t mask;
+	int searches;
+	size_t len;
+	char path[];
+} *dir_lists;
+
+static void list_dir(struct dir_list *d)
+{
+	char buf[2048];
+	struct dirent *de;
+	uint32_t *tab = 0, *new, h;
+	size_t mask = 0, cnt = 0, i, j, k;
+	long r;
+	int fd = open(d->path, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+	if (fd < 0) return;
+	while ((r = __syscall(SYS_getdents, fd, buf, sizeof buf)) > 0) {
+		for (i=0; i<r; i+=de->d_reclen) {
+			de = (void *)(buf+i);
+			if (2*++cnt > mask) {
+				mask = 2*mask+1 | 255;
+				if (!(new = calloc(mask+1, sizeof *new))) {
+					r = -1;
+					goto done;
+				}
+				for (j=0; tab && j<=mask/2; j++) {
+					if (!tab[j]) continue;
+					for (k=tab[j]; new[k&mask]; k++);
+					new[k&mask] = tab[j];
+				}
+				free(tab);
+				tab = new;
+			}
+			h = gnu_hash(de->d_name) | 1;
+			for (j=h; tab[j&mask] && tab[j&mask]!=h; j++);
+			tab[j&mask] = h;
+		}
+	}
+done:
+	close(fd);
+	if (r < 0) {
+		free(tab);
+		return;
+	}
+	d->tab = tab;
+	d->mask = mask;
+}
+
+static int dir_may_have(const char *dir, size_t l, const char *name)
+{
+	struct dir_list *d;
+	uint32_t h;
+	size_t i;
+
+	for (d=dir_lists; d; d=d->next)
+		if (d->len == l && !memcmp(d->path, dir, l)) break;
+	if (!d) {
+		if (!(d = malloc(sizeof *d + l + 1))) return 1;
+		memcpy(d->path, dir, l);
+		d->path[l] = 0;
+		d->len = l;
+		d->tab = 0;
+		d->searches = 0;
+		d->next = dir_lists;
+		dir_lists = d;
+	}
+	if (++d->searches == 2) list_dir(d);
+	if (!d->tab) return 1;
+	h = gnu_hash(name) | 1;
+	for (i=h; d->tab[i&d->mask]; i++)
+		if (d->tab[i&d->mask] == h) return 1;
+	return 0;
+}
+
+static void free_dir_lists(void)
+{
+	struct dir_list *d, *next;
+	for (d=dir_lists; d; d=next) {
+		next = d->next;
+		free(d->tab);
+		free(d);
+	}
+	dir_lists = 0;
+}
+
 static int path_open(const char *name, const char *s, char *buf, size_t buf_size)
 {
 	size_t l;
@@ -878,6 +1206,10 @@ static int path_open(const char *name, const char *s, char *buf, size_t buf_size
 		s += strspn(s, ":\n");
 		l = strcspn(s, ":\n");
 		if (l-1 >= INT_MAX) return -1;
+		if (!dir_may_have(s, l, name)) {
+			s += l;
+			continue;
+		}
 		if (snprintf(buf, buf_size, "%.*s/%s", (int)l, s, name) < buf_size) {
 			if ((fd = open(buf, O_RDONLY|O_CLOEXEC))>=0) return fd;
 			switch (errno) {
@@ -1052,6 +1384,93 @@ static void makefuncdescs(struct dso *p)
 	}
 }
 
+static void assign_tls_offset(struct dso *p, size_t *cur)
+{
+#ifdef TLS_ABOVE_TP
+	p->tls.offset = *cur + ( (p->tls.align-1) &
+		(-*cur + (uintptr_t)p->tls.image) );
+	*cur = p->tls.offset + p->tls.size;
+#else
+	*cur += p->tls.size + p->tls.align - 1;
+	*cur -= (*cur + (uintptr_t)p->tls.image)
+		& (p->tls.align-1);
+	p->tls.offset = *cur;
+#endif
+}
+
+/* Open-addressed hash indexes of the DSOs after head, by shortname and
+ * by dev/ino, used by load_library to find already-loaded libraries.
+ * Where keys collide the earliest DSO in the list is kept, giving the
+ * same answer as walking the list, which is done instead when the
+ * tables could not be allocated. */
+static struct dso **dso_slot(struct dso **tab, const char *name,
+	dev_t dev, ino_t ino)
+{
+	size_t i;
+	struct dso *p;
+	if (name) i = gnu_hash(name);
+	else i = ((size_t)ino ^ (size_t)dev) * 2654435761u;
+	for (;; i++) {
+		p = tab[i & dso_index_mask];
+		if (!p || (name ? !strcmp(p->shortname, name)
+		               : p->dev == dev && p->ino == ino))
+			return tab + (i & dso_index_mask);
+	}
+}
+
+static void index_dso_name(struct dso *p)
+{
+	struct dso **s;
+	if (!dso_by_name || !p->shortname) return;
+	s = dso_slot(dso_by_name, p->shortname, 0, 0);
+	if (!*s) *s = p;
+}
+
+static void index_dso_id(struct dso *p)
+{
+	/* ldso and the vdso share a zero dev/ino; keep the first, as
+	 * the list walk would find. */
+	struct dso **s = dso_slot(dso_by_id, 0, p->dev, p->ino);
+	if (!*s) *s = p;
+}
+
+/* (Re)build both tables from the list. Called when they fill up and
+ * after a failed dlopen removes DSOs. */
+static void index_dsos(void)
+{
+	struct dso *p;
+	size_t n, mask;
+
+	for (n=0, p=head->next; p; p=p->next) n++;
+	for (mask=63; mask < 2*n; mask = 2*mask+1);
+	free(dso_by_name);
+	free(dso_by_id);
+	dso_by_name = calloc(mask+1, sizeof *dso_by_name);
+	dso_by_id = calloc(mask+1, sizeof *dso_by_id);
+	if (!dso_by_name || !dso_by_id) {
+		free(dso_by_name);
+		free(dso_by_id);
+		dso_by_name = dso_by_id = 0;
+		return;
+	}
+	dso_index_mask = mask;
+	dso_index_cnt = n;
+	for (p=head->next; p; p=p->next) {
+		index_dso_id(p);
+		index_dso_name(p);
+	}
+}
+
+static void index_dso(struct dso *p)
+{
+	if (!dso_by_id || 2*++dso_index_cnt > dso_index_mask) {
+		index_dsos();
+		return;
+	}
+	index_dso_id(p);
+	index_dso_name(p);
+}
+
 static struct dso *load_library(const char *name, struct dso *needed_by)
 {
 	char buf[2*NAME_MAX+2];
@@ -1063,6 +1482,7 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 	size_t alloc_size;
 	int n_th = 0;
 	int is_self = 0;
+	unsigned long long t = 0;
 
 	if (!*name) {
 		errno = EINVAL;
@@ -1101,6 +1521,7 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 			tail->next = &ldso;
 			ldso.prev = tail;
 			tail = &ldso;
+			index_dso(&ldso);
 		}
 		return &ldso;
 	}
@@ -1109,7 +1530,10 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 		fd = open(name, O_RDONLY|O_CLOEXEC);
 	} else {
 		/* Search for the name to see if it's already loaded */
-		for (p=head->next; p; p=p->next) {
+		if (dso_by_name) {
+			if ((p = *dso_slot(dso_by_name, name, 0, 0)))
+				return p;
+		} else for (p=head->next; p; p=p->next) {
 			if (p->shortname && !strcmp(p->shortname, name)) {
 				return p;
 			}
@@ -1169,18 +1593,23 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 		close(fd);
 		return 0;
 	}
-	for (p=head->next; p; p=p->next) {
-		if (p->dev == st.st_dev && p->ino == st.st_ino) {
-			/* If this library was previously loaded with a
-			 * pathname but a search found the same inode,
-			 * setup its shortname so it can be found by name. */
-			if (!p->shortname && pathname != name)
-				p->shortname = strrchr(p->name, '/')+1;
-			close(fd);
-			return p;
+	if (dso_by_id) p = *dso_slot(dso_by_id, 0, st.st_dev, st.st_ino);
+	else for (p=head->next; p; p=p->next)
+		if (p->dev == st.st_dev && p->ino == st.st_ino) break;
+	if (p) {
+		/* If this library was previously loaded with a
+		 * pathname but a search found the same inode,
+		 * setup its shortname so it can be found by name. */
+		if (!p->shortname && pathname != name) {
+			p->shortname = strrchr(p->name, '/')+1;
+			index_dso_name(p);
 		}
+		close(fd);
+		return p;
 	}
+	if (stats.out) t = stats_now();
 	map = noload ? 0 : map_library(fd, &temp_dso);
+	if (stats.out) t = stats_now() - t;
 	close(fd);
 	if (!map) return 0;
 
@@ -1220,7 +1649,10 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 	memcpy(p, &temp_dso, sizeof temp_dso);
 	p->dev = st.st_dev;
 	p->ino = st.st_ino;
+	p->file_size = st.st_size;
+	p->file_mtim = st.st_mtim;
 	p->needed_by = needed_by;
+	p->map_ns = t;
 	p->name = p->buf;
 	p->runtime_loaded = runtime;
 	strcpy(p->name, pathname);
@@ -1229,16 +1661,17 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 	if (p->tls.image) {
 		p->tls_id = ++tls_cnt;
 		tls_align = MAXP2(tls_align, p->tls.align);
-#ifdef TLS_ABOVE_TP
-		p->tls.offset = tls_offset + ( (p->tls.align-1) &
-			(-tls_offset + (uintptr_t)p->tls.image) );
-		tls_offset = p->tls.offset + p->tls.size;
-#else
-		tls_offset += p->tls.size + p->tls.align - 1;
-		tls_offset -= (tls_offset + (uintptr_t)p->tls.image)
-			& (p->tls.align-1);
-		p->tls.offset = tls_offset;
-#endif
+		/* Modules loaded at runtime that fit in the surplus reserved
+		 * at startup get an offset every thread already has room
+		 * for, and can then be accessed with the static models. */
+		size_t cur = surplus_offset;
+		if (runtime && p->tls.align <= static_tls_align
+		    && (assign_tls_offset(p, &cur), cur <= surplus_end)) {
+			surplus_offset = cur;
+			p->tls_static = 1;
+		} else {
+			assign_tls_offset(p, &tls_offset);
+		}
 		p->new_dtv = (void *)(-sizeof(size_t) &
 			(uintptr_t)(p->name+strlen(p->name)+sizeof(size_t)));
 		p->new_tls = (void *)(p->new_dtv + n_th*(tls_cnt+1));
@@ -1250,6 +1683,7 @@ static struct dso *load_library(const char *name, struct dso *needed_by)
 	tail->next = p;
 	p->prev = tail;
 	tail = p;
+	index_dso(p);
 
 	if (DL_FDPIC) makefuncdescs(p);
 
@@ -1407,20 +1841,167 @@ static void do_mips_relocs(struct dso *p, size_t *got)
 	}
 }
 
+static size_t count_relr(size_t *relr, size_t relr_size)
+{
+	size_t n = 0, bitmap;
+	for (; relr_size; relr++, relr_size-=sizeof(size_t))
+		if ((relr[0]&1) == 0) n++;
+		else for (bitmap=relr[0]; (bitmap>>=1); ) n += bitmap&1;
+	return n;
+}
+
+/* Opt-in (LD_RELOC_THREADS) application of the relative relocations
+ * of the initial DSOs by helper threads before the rest are done.
+ * These need no symbol lookup and each writes only its own slot, so
+ * they can be applied in any order; reloc_all then skips them. The
+ * helpers are bare clones sharing the main thread's thread pointer,
+ * and must not touch TLS, errno or anything else but the tables. */
+#define RELOC_CHUNK 4096
+#define RELOC_STACK 16384
+#define RELOC_THREADS_MAX 16
+
+static struct reloc_chunk {
+	struct dso *dso;
+	size_t *rel, len, stride;
+} *reloc_chunks;
+static int reloc_chunk_cnt;
+static volatile int reloc_chunk_next;
+
+/* Split a table into chunks of about RELOC_CHUNK entries, stored to c
+ * unless it is null, and return their number. A RELR table (stride 0)
+ * can only be split before an address entry. */
+static size_t split_relocs(struct reloc_chunk *c, struct dso *p,
+	size_t *rel, size_t size, size_t stride)
+{
+	size_t w = stride ? stride : 1, len = size / (w*sizeof(size_t));
+	size_t i, j, n;
+	for (i=n=0; i<len; i=j, n++) {
+		j = len-i > RELOC_CHUNK ? i+RELOC_CHUNK : len;
+		if (!stride) while (j<len && (rel[j]&1)) j++;
+		if (c) c[n] = (struct reloc_chunk){
+			.dso = p, .rel = rel+i*w, .len = j-i, .stride = stride };
+	}
+	return n;
+}
+
+static int reloc_worker(void *unused)
+{
+	struct reloc_chunk *c;
+	size_t *rel, n, *reloc_addr;
+	int i;
+	while ((i = a_fetch_add(&reloc_chunk_next, 1)) < reloc_chunk_cnt) {
+		c = reloc_chunks + i;
+		if (!c->stride) {
+			do_relr_relocs(c->dso, c->rel, c->len*sizeof(size_t));
+			continue;
+		}
+		for (rel=c->rel, n=c->len; n; n--, rel+=c->stride) {
+			if (!IS_RELATIVE(rel[1], c->dso->syms)) continue;
+			reloc_addr = laddr(c->dso, rel[0]);
+			*reloc_addr = (size_t)c->dso->base
+				+ (c->stride > 2 ? rel[2] : *reloc_addr);
+		}
+	}
+	return 0;
+}
+
+static size_t split_all_relocs(struct reloc_chunk *c)
+{
+	struct dso *p;
+	size_t dyn[DYN_CNT], n = 0;
+	for (p=head; p; p=p->next) {
+		if (p->relocated || p == &ldso) continue;
+		decode_vec(p->dynv, dyn, DYN_CNT);
+		n += split_relocs(c ? c+n : 0, p,
+			laddr(p, dyn[DT_JMPREL]), dyn[DT_PLTRELSZ],
+			2+(dyn[DT_PLTREL]==DT_RELA));
+		n += split_relocs(c ? c+n : 0, p,
+			laddr(p, dyn[DT_REL]), dyn[DT_RELSZ], 2);
+		n += split_relocs(c ? c+n : 0, p,
+			laddr(p, dyn[DT_RELA]), dyn[DT_RELASZ], 3);
+		n += split_relocs(c ? c+n : 0, p,
+			laddr(p, dyn[DT_RELR]), dyn[DT_RELRSZ], 0);
+	}
+	return n;
+}
+
+static void reloc_relative_parallel(int nthreads)
+{
+	struct dso *p;
+	size_t n, i;
+	volatile int tid[RELOC_THREADS_MAX];
+	unsigned char *stacks = MAP_FAILED, cpus[128];
+	sigset_t set;
+	int t, ncpu = 0;
+	long r;
+
+	if (DL_FDPIC || NEED_MIPS_GOT_RELOCS) return;
+	n = split_all_relocs(0);
+	if (n < 2 || n > INT_MAX) return;
+	reloc_chunks = calloc(n, sizeof *reloc_chunks);
+	if (!reloc_chunks) return;
+	reloc_chunk_cnt = split_all_relocs(reloc_chunks);
+
+	/* Helpers beyond the CPUs available would only add overhead. */
+	r = __syscall(SYS_sched_getaffinity, 0, sizeof cpus, cpus);
+	if (r > 0) for (i=0; i<(size_t)r; i++)
+		for (t=cpus[i]; t; t&=t-1) ncpu++;
+	if (ncpu && nthreads > ncpu-1) nthreads = ncpu-1;
+	if (nthreads > RELOC_THREADS_MAX) nthreads = RELOC_THREADS_MAX;
+	if (nthreads > n-1) nthreads = n-1;
+	if (nthreads) stacks = mmap(0, nthreads*RELOC_STACK,
+		PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (stacks == MAP_FAILED) nthreads = 0;
+	__block_all_sigs(&set);
+	for (i=0; i<nthreads; i++) {
+		tid[i] = 0;
+		__clone(reloc_worker, stacks + (i+1)*RELOC_STACK,
+			CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND
+			| CLONE_THREAD | CLONE_SYSVSEM
+			| CLONE_PARENT_SETTID | CLONE_CHILD_CLEARTID,
+			0, tid+i, 0, tid+i);
+	}
+	__restore_sigs(&set);
+	reloc_worker(0);
+	for (i=0; i<nthreads; i++)
+		while ((t = tid[i])) __wait(tid+i, 0, t, 0);
+	if (nthreads) munmap(stacks, nthreads*RELOC_STACK);
+
+	for (p=head; p; p=p->next)
+		if (!p->relocated && p != &ldso) p->relative_done = 1;
+	free(reloc_chunks);
+	reloc_chunks = 0;
+}
+
 static void reloc_all(struct dso *p)
 {
-	size_t dyn[DYN_CNT];
+	size_t dyn[DYN_CNT], lookups;
+	unsigned long long t;
 	for (; p; p=p->next) {
 		if (p->relocated) continue;
 		decode_vec(p->dynv, dyn, DYN_CNT);
+		if (stats.out) {
+			t = stats_now();
+			lookups = stats.lookups;
+		}
 		if (NEED_MIPS_GOT_RELOCS)
 			do_mips_relocs(p, laddr(p, dyn[DT_PLTGOT]));
 		do_relocs(p, laddr(p, dyn[DT_JMPREL]), dyn[DT_PLTRELSZ],
 			2+(dyn[DT_PLTREL]==DT_RELA));
 		do_relocs(p, laddr(p, dyn[DT_REL]), dyn[DT_RELSZ], 2);
 		do_relocs(p, laddr(p, dyn[DT_RELA]), dyn[DT_RELASZ], 3);
-		if (!DL_FDPIC)
+		if (!DL_FDPIC && !p->relative_done)
 			do_relr_relocs(p, laddr(p, dyn[DT_RELR]), dyn[DT_RELRSZ]);
+		if (stats.out) {
+			p->reloc_ns += stats_now() - t;
+			p->nlookups += stats.lookups - lookups;
+			p->nrelocs += dyn[DT_PLTRELSZ]
+				/ ((2+(dyn[DT_PLTREL]==DT_RELA))*sizeof(size_t))
+				+ dyn[DT_RELSZ] / (2*sizeof(size_t))
+				+ dyn[DT_RELASZ] / (3*sizeof(size_t));
+			if (!DL_FDPIC) p->nrelocs += count_relr(
+				laddr(p, dyn[DT_RELR]), dyn[DT_RELRSZ]);
+		}
 
 		if (head != &ldso && p->relro_start != p->relro_end) {
 			long ret = __syscall(SYS_mprotect, laddr(p, p->relro_start),
@@ -1436,6 +2017,218 @@ static void reloc_all(struct dso *p)
 	}
 }
 
+/* The identity of a DSO comes from the fstat of the descriptor it was
+ * mapped from, so it describes the image actually being relocated.
+ * Only objects mapped by the kernel lack one: the main program is
+ * then identified through /proc/self/exe, which names the executed
+ * file itself, and ldso by its pathname. */
+static int bind_ident(struct dso *p, uint64_t *id)
+{
+	struct stat st;
+	if (p->dev || p->ino) {
+		id[0] = p->dev;
+		id[1] = p->ino;
+		id[2] = p->file_size;
+		id[3] = p->file_mtim.tv_sec;
+		id[4] = p->file_mtim.tv_nsec;
+		return 0;
+	}
+	if (stat(p == head && p->kernel_mapped ? "/proc/self/exe"
+	    : p->name, &st))
+		return -1;
+	id[0] = st.st_dev;
+	id[1] = st.st_ino;
+	id[2] = st.st_size;
+	id[3] = st.st_mtim.tv_sec;
+	id[4] = st.st_mtim.tv_nsec;
+	return 0;
+}
+
+static void bind_cache_open(void)
+{
+	struct dso *p;
+	struct bind_cache_hdr *h;
+	struct stat st;
+	size_t i, n;
+	int fd;
+
+	for (n=0, p=head; p; p=p->next) n++;
+	bind_dsos = calloc(n, sizeof *bind_dsos);
+	if (!bind_dsos) return;
+	for (i=0, p=head; p; p=p->next) {
+		/* The vdso is not part of the global namespace. */
+		if (!*p->name) continue;
+		if (bind_ident(p, bind_dsos[i].id)) {
+			free(bind_dsos);
+			bind_dsos = 0;
+			return;
+		}
+		bind_dsos[i].dso = p;
+		p->bind_index = i++;
+	}
+	bind_ndso = i;
+
+	fd = open(bind_cache_path, O_RDONLY|O_CLOEXEC);
+	if (fd >= 0) {
+		if (!fstat(fd, &st) && st.st_size >= sizeof *h) {
+			bind_map_len = st.st_size;
+			bind_map = mmap(0, bind_map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (bind_map == MAP_FAILED) bind_map = 0;
+		}
+		close(fd);
+	}
+	n = sizeof *h + bind_ndso*sizeof bind_dsos->id;
+	if ((h = bind_map) && h->magic == BIND_CACHE_MAGIC
+	    && h->ndso == bind_ndso && bind_map_len >= n
+	    && h->nbind <= (bind_map_len - n) / (3*sizeof *bind_in)) {
+		uint64_t *id = (void *)(h+1);
+		for (i=0; i<bind_ndso; i++, id+=5)
+			if (memcmp(id, bind_dsos[i].id, sizeof bind_dsos->id))
+				break;
+		if (i == bind_ndso) {
+			for (i=0; i<bind_ndso; i++)
+				bind_dsos[i].nsyms = count_syms(bind_dsos[i].dso);
+			bind_in = (void *)id;
+			bind_in_cnt = h->nbind;
+			return;
+		}
+	}
+	/* Start recording; a failed allocation just disables it. */
+	bind_grow(0);
+}
+
+static void bind_cache_close(void)
+{
+	struct bind_cache_hdr h;
+	char tmp[PATH_MAX];
+	size_t i;
+	int fd;
+
+	if (bind_in && bind_pos != bind_in_cnt) bind_miss();
+	if (bind_out && !ldso_fail && (unsigned)snprintf(tmp, sizeof tmp,
+	    "%s.%d", bind_cache_path, getpid()) < sizeof tmp
+	    && (fd = open(tmp, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0644)) >= 0) {
+		h = (struct bind_cache_hdr){ .magic = BIND_CACHE_MAGIC,
+			.ndso = bind_ndso, .nbind = bind_out_cnt };
+		int ok = write(fd, &h, sizeof h) == sizeof h;
+		for (i=0; ok && i<bind_ndso; i++)
+			ok = write(fd, bind_dsos[i].id, sizeof bind_dsos->id)
+				== sizeof bind_dsos->id;
+		ok = ok && write(fd, bind_out, 3*bind_out_cnt*sizeof *bind_out)
+			== 3*bind_out_cnt*sizeof *bind_out;
+		close(fd);
+		if (!ok || rename(tmp, bind_cache_path)) unlink(tmp);
+	}
+	if (bind_map) munmap(bind_map, bind_map_len);
+	free(bind_out);
+	free(bind_dsos);
+	bind_in = bind_out = 0;
+	bind_dsos = 0;
+}
+
+static int addr_range_cmp(const void *a, const void *b)
+{
+	const struct addr_range *x = a, *y = b;
+	return x->start < y->start ? -1 : x->start > y->start;
+}
+
+/* Add the segments of DSOs loaded since the last call to the sorted
+ * index used by addr2dso. Must be called with the lock held for
+ * writing whenever DSOs are added; if it cannot be allocated, addr2dso
+ * falls back to a linear walk and the next call starts over. */
+static void update_addr_index(void)
+{
+	struct addr_range *r, new;
+	struct dso *p, *first;
+	Phdr *ph;
+	size_t i, n, lo, hi, mid;
+
+	if (DL_FDPIC) return;
+	if (!addr_index) addr_index_tail = 0, addr_index_cnt = 0;
+	first = addr_index_tail ? addr_index_tail->next : head;
+	for (n=addr_index_cnt, p=first; p; p=p->next)
+		for (i=0, ph=p->phdr; i<p->phnum;
+		     i++, ph=(void *)((char *)ph+p->phentsize))
+			n += ph->p_type == PT_LOAD;
+	r = realloc(addr_index, n * sizeof *r);
+	if (!r) {
+		free(addr_index);
+		addr_index = 0;
+		return;
+	}
+	addr_index = r;
+	for (n=addr_index_cnt, p=first; p; p=p->next)
+		for (i=0, ph=p->phdr; i<p->phnum;
+		     i++, ph=(void *)((char *)ph+p->phentsize)) {
+			if (ph->p_type != PT_LOAD || !ph->p_memsz) continue;
+			new.start = (size_t)p->base + ph->p_vaddr;
+			new.end = new.start + ph->p_memsz;
+			new.dso = p;
+			if (first == head) {
+				r[n++] = new;
+				continue;
+			}
+			for (lo=0, hi=n; lo<hi; ) {
+				mid = lo + (hi-lo)/2;
+				if (r[mid].start < new.start) lo = mid+1;
+				else hi = mid;
+			}
+			memmove(r+lo+1, r+lo, (n-lo) * sizeof *r);
+			r[lo] = new;
+			n++;
+		}
+	if (first == head) qsort(r, n, sizeof *r, addr_range_cmp);
+	addr_index_cnt = n;
+	addr_index_tail = tail;
+}
+
+/* Publish a new snapshot of the loaded objects for lock-free readers.
+ * Since objects are never removed, entries once filled in are never
+ * changed, and old snapshots (and arrays they point into) stay valid
+ * for readers that cached them. Called with the lock held for writing
+ * after objects are added. */
+static void update_phdr_snapshot(void)
+{
+	struct dl_phdr_snapshot *s;
+	struct dl_phdr_info *info = phdr_info;
+	struct dso *p, *first;
+	size_t i, n;
+
+	first = phdr_info_tail ? phdr_info_tail->next : head;
+	for (n=phdr_info_cnt, p=first; p; p=p->next) n++;
+	gencnt = n;
+	s = malloc(sizeof *s);
+	if (s && n > phdr_info_size) {
+		info = malloc(2*n * sizeof *info);
+		if (info && phdr_info_cnt)
+			memcpy(info, phdr_info, phdr_info_cnt * sizeof *info);
+	}
+	if (!s || !info) {
+		free(s);
+		phdr_snapshot = 0;
+		return;
+	}
+	if (info != phdr_info) {
+		phdr_info = info;
+		phdr_info_size = 2*n;
+	}
+	for (i=phdr_info_cnt, p=first; p; i++, p=p->next) {
+		info[i] = (struct dl_phdr_info){
+			.dlpi_addr = (uintptr_t)p->base,
+			.dlpi_name = p->name,
+			.dlpi_phdr = p->phdr,
+			.dlpi_phnum = p->phnum,
+			.dlpi_tls_modid = p->tls_id,
+		};
+	}
+	phdr_info_cnt = n;
+	phdr_info_tail = tail;
+	*s = (struct dl_phdr_snapshot){ .dlps_adds = n, .dlps_count = n,
+		.dlps_info = info };
+	a_barrier();
+	phdr_snapshot = s;
+}
+
 static void kernel_mapped_dso(struct dso *p)
 {
 	size_t min_addr = -1, max_addr = 0, cnt;
@@ -1581,6 +2374,7 @@ static void do_init_fini(struct dso **queue)
 	struct dso *p;
 	size_t dyn[DYN_CNT], i;
 	pthread_t self = __pthread_self();
+	unsigned long long t;
 
 	pthread_mutex_lock(&init_fini_lock);
 	for (i=0; (p=queue[i]); i++) {
@@ -1598,6 +2392,7 @@ static void do_init_fini(struct dso **queue)
 
 		pthread_mutex_unlock(&init_fini_lock);
 
+		if (stats.out) t = stats_now();
 #ifndef NO_LEGACY_INITFINI
 		if ((dyn[0] & (1<<DT_INIT)) && dyn[DT_INIT])
 			fpaddr(p, dyn[DT_INIT])();
@@ -1607,6 +2402,7 @@ static void do_init_fini(struct dso **queue)
 			size_t *fn = laddr(p, dyn[DT_INIT_ARRAY]);
 			while (n--) ((void (*)(void))*fn++)();
 		}
+		if (stats.out) p->init_ns = stats_now() - t;
 
 		pthread_mutex_lock(&init_fini_lock);
 		p->ctor_visitor = 0;
@@ -1616,12 +2412,49 @@ static void do_init_fini(struct dso **queue)
 	pthread_mutex_unlock(&init_fini_lock);
 }
 
+static void report_stats(void)
+{
+	struct dso *p;
+	size_t n, relocs = 0;
+	int fd = 2;
+
+	if (strchr(stats.out, '/')) {
+		fd = open(stats.out, O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC, 0644);
+		if (fd < 0) return;
+	}
+	for (n=0, p=head; p; n++, p=p->next) relocs += p->nrelocs;
+	dprintf(fd, "ldso: startup statistics for %s (pid %d)\n"
+		"ldso:   load  %8llu us (%zu objects)\n"
+		"ldso:   tls   %8llu us\n"
+		"ldso:   reloc %8llu us (%zu relocations, %zu symbol lookups)\n"
+		"ldso:   init  %8llu us\n"
+		"ldso:   total %8llu us\n"
+		"ldso:        map    reloc     init   relocs  lookups  object\n",
+		head->name, getpid(),
+		stats.load/1000, n, stats.tls/1000,
+		stats.reloc/1000, relocs, stats.lookups,
+		stats.init/1000,
+		(stats.entry - stats.start + stats.init)/1000);
+	for (p=head; p; p=p->next)
+		dprintf(fd, "ldso: %8llu %8llu %8llu %8zu %8zu  %s\n",
+			p->map_ns/1000, p->reloc_ns/1000, p->init_ns/1000,
+			p->nrelocs, p->nlookups,
+			*p->name ? p->name : p->shortname);
+	if (fd != 2) close(fd);
+}
+
 void __libc_start_init(void)
 {
+	unsigned long long t;
+	if (stats.out) t = stats_now();
 	do_init_fini(main_ctor_queue);
 	if (!__malloc_replaced && main_ctor_queue != builtin_ctor_queue)
 		free(main_ctor_queue);
 	main_ctor_queue = 0;
+	if (stats.out) {
+		stats.init = stats_now() - t;
+		report_stats();
+	}
 }
 
 static void dl_debug_state(void)
@@ -1664,9 +2497,27 @@ static void install_new_tls(void)
 			(old_cnt+1)*sizeof(uintptr_t));
 		newdtv[i][0] = tls_cnt;
 	}
-	/* Install new dtls into the enlarged, uninstalled dtv copies. */
+	/* Install new dtls into the enlarged, uninstalled dtv copies.
+	 * Modules placed in the static surplus go at their fixed offset
+	 * from each thread pointer, in space that is still zero. */
 	for (p=head; ; p=p->next) {
 		if (p->tls_id <= old_cnt) continue;
+		if (p->tls_static) {
+			for (j=0, td=self; !j || td!=self; j++, td=td->next) {
+#ifdef TLS_ABOVE_TP
+				unsigned char *new = (unsigned char *)(td+1)
+					+ p->tls.offset;
+#else
+				unsigned char *new = (unsigned char *)td
+					- p->tls.offset;
+#endif
+				memcpy(new, p->tls.image, p->tls.len);
+				newdtv[j][p->tls_id] =
+					(uintptr_t)new + DTP_OFFSET;
+			}
+			if (p->tls_id == tls_cnt) break;
+			continue;
+		}
 		unsigned char *mem = p->new_tls;
 		for (j=0; j<i; j++) {
 			unsigned char *new = mem;
@@ -1802,6 +2653,7 @@ void __dls3(size_t *sp, size_t *auxv)
 	size_t aux[AUX_CNT];
 	size_t i;
 	char *env_preload=0;
+	char *env;
 	char *replace_argv0=0;
 	size_t vdso_base;
 	int argc = *sp;
@@ -1823,6 +2675,16 @@ void __dls3(size_t *sp, size_t *auxv)
 	if (!libc.secure) {
 		env_path = getenv("LD_LIBRARY_PATH");
 		env_preload = getenv("LD_PRELOAD");
+		bind_cache_path = getenv("LD_BIND_CACHE");
+		if ((env = getenv("LD_RELOC_THREADS")))
+			reloc_threads = atoi(env);
+		stats.out = getenv("LD_STATS");
+		if (stats.out && !*stats.out) stats.out = 0;
+		/* Leave out the lookups made relocating ldso itself. */
+		if (stats.out) {
+			stats.start = stats_now();
+			stats.lookups = 0;
+		}
 	}
 
 	/* Activate error handler function */
@@ -1861,6 +2723,7 @@ void __dls3(size_t *sp, size_t *auxv)
 		kernel_mapped_dso(&app);
 	} else {
 		int fd;
+		struct stat st;
 		char *ldname = argv[0];
 		size_t l = strlen(ldname);
 		if (l >= 3 && !strcmp(ldname+l-3, "ldd")) ldd_mode = 1;
@@ -1908,6 +2771,12 @@ void __dls3(size_t *sp, size_t *auxv)
 			dprintf(2, "%s: %s: Not a valid dynamic program\n", ldname, argv[0]);
 			_exit(1);
 		}
+		if (!fstat(fd, &st)) {
+			app.dev = st.st_dev;
+			app.ino = st.st_ino;
+			app.file_size = st.st_size;
+			app.file_mtim = st.st_mtim;
+		}
 		close(fd);
 		ldso.name = ldname;
 		app.name = argv[0];
@@ -1959,11 +2828,14 @@ void __dls3(size_t *sp, size_t *auxv)
 	reclaim_gaps(&ldso);
 
 	/* Load preload/needed libraries, add symbols to global namespace. */
+	if (stats.out) stats.load = stats_now();
 	ldso.deps = (struct dso **)no_deps;
 	if (env_preload) load_preload(env_preload);
  	load_deps(&app);
+	free_dir_lists();
 	for (struct dso *p=head; p; p=p->next)
 		add_syms(p);
+	if (stats.out) stats.load = stats_now() - stats.load;
 
 	/* Attach to vdso, if provided by the kernel, last so that it does
 	 * not become part of the global namespace.  */
@@ -1986,6 +2858,7 @@ void __dls3(size_t *sp, size_t *auxv)
 		vdso.prev = tail;
 		tail->next = &vdso;
 		tail = &vdso;
+		index_dso(&vdso);
 	}
 
 	for (i=0; app.dynv[i]; i+=2) {
@@ -2009,8 +2882,21 @@ void __dls3(size_t *sp, size_t *auxv)
 	 * code can see to perform. */
 	main_ctor_queue = queue_ctors(&app);
 
+	/* Reserve static TLS surplus for modules loaded later by dlopen.
+	 * Thread pointers are aligned for the largest alignment such a
+	 * module may ask for, since existing threads cannot be moved. */
+	surplus_offset = tls_offset;
+	tls_offset += TLS_SURPLUS;
+	surplus_end = tls_offset;
+	tls_align = MAXP2(tls_align, TLS_SURPLUS_ALIGN);
+	static_tls_align = tls_align;
+
+	/* The rseq area in struct pthread needs at least RSEQ_ALIGN. */
+	tls_align = MAXP2(tls_align, RSEQ_ALIGN);
+
 	/* Initial TLS must also be allocated before final relocations
 	 * might result in calloc being a call to application code. */
+	if (stats.out) stats.tls = stats_now();
 	update_tls_size();
 	void *initial_tls = builtin_tls;
 	if (libc.tls_size > sizeof builtin_tls || tls_align > MIN_TLS_ALIGN) {
@@ -2022,14 +2908,27 @@ void __dls3(size_t *sp, size_t *auxv)
 		}
 	}
 	static_tls_cnt = tls_cnt;
+	if (stats.out) stats.tls = stats_now() - stats.tls;
+
+	sym_cache = calloc(1024, sizeof *sym_cache);
+	if (sym_cache) sym_cache_mask = 1023;
+	if (bind_cache_path && *bind_cache_path) bind_cache_open();
 
 	/* The main program must be relocated LAST since it may contain
 	 * copy relocations which depend on libraries' relocations. */
+	if (stats.out) stats.reloc = stats_now();
+	if (reloc_threads > 0) reloc_relative_parallel(reloc_threads);
 	reloc_all(app.next);
 	reloc_all(&app);
+	if (stats.out) stats.reloc = stats_now() - stats.reloc;
+
+	free(sym_cache);
+	sym_cache = 0;
+	if (bind_dsos) bind_cache_close();
 
 	/* Actual copying to new TLS needs to happen after relocations,
 	 * since the TLS images might have contained relocated addresses. */
+	if (stats.out) stats.tls -= stats_now();
 	if (initial_tls != builtin_tls) {
 		if (__init_tp(__copy_tls(initial_tls)) < 0) {
 			a_crash();
@@ -2044,6 +2943,7 @@ void __dls3(size_t *sp, size_t *auxv)
 		if (__copy_tls((void*)builtin_tls) != self) a_crash();
 		libc.tls_size = tmp_tls_size;
 	}
+	if (stats.out) stats.tls += stats_now();
 
 	if (ldso_fail) _exit(127);
 	if (ldd_mode) _exit(0);
@@ -2061,6 +2961,9 @@ void __dls3(size_t *sp, size_t *auxv)
 	 * error. */
 	runtime = 1;
 
+	update_addr_index();
+	update_phdr_snapshot();
+
 	debug.ver = 1;
 	debug.bp = dl_debug_state;
 	debug.head = head;
@@ -2072,6 +2975,7 @@ void __dls3(size_t *sp, size_t *auxv)
 
 	errno = 0;
 
+	if (stats.out) stats.entry = stats_now();
 	CRTJMP((void *)aux[AT_ENTRY], argv-1);
 	for(;;);
 }
@@ -2102,7 +3006,7 @@ void *dlopen(const char *file, int mode)
 {
 	struct dso *volatile p, *orig_tail, *orig_syms_tail, *orig_lazy_head, *next;
 	struct tls_module *orig_tls_tail;
-	size_t orig_tls_cnt, orig_tls_offset, orig_tls_align;
+	size_t orig_tls_cnt, orig_tls_offset, orig_tls_align, orig_surplus_offset;
 	size_t i;
 	int cs;
 	jmp_buf jb;
@@ -2126,6 +3030,7 @@ void *dlopen(const char *file, int mode)
 	orig_tls_cnt = tls_cnt;
 	orig_tls_offset = tls_offset;
 	orig_tls_align = tls_align;
+	orig_surplus_offset = surplus_offset;
 	orig_lazy_head = lazy_head;
 	orig_syms_tail = syms_tail;
 	orig_tail = tail;
@@ -2157,9 +3062,11 @@ void *dlopen(const char *file, int mode)
 		tls_cnt = orig_tls_cnt;
 		tls_offset = orig_tls_offset;
 		tls_align = orig_tls_align;
+		surplus_offset = orig_surplus_offset;
 		lazy_head = orig_lazy_head;
 		tail = orig_tail;
 		tail->next = 0;
+		if (dso_by_id) index_dsos();
 		p = 0;
 		goto end;
 	} else p = load_library(file, head);
@@ -2210,12 +3117,16 @@ void *dlopen(const char *file, int mode)
 	update_tls_size();
 	if (tls_cnt != orig_tls_cnt)
 		install_new_tls();
+	if (tail != orig_tail) {
+		update_addr_index();
+		update_phdr_snapshot();
+	}
 	orig_tail = tail;
 end:
+	free_dir_lists();
 	debug.state = RT_CONSISTENT;
 	_dl_debug_state();
 	__release_ptc();
-	if (p) gencnt++;
 	pthread_rwlock_unlock(&lock);
 	if (ctor_queue) {
 		do_init_fini(ctor_queue);
@@ -2237,6 +3148,17 @@ static void *addr2dso(size_t a)
 {
 	struct dso *p;
 	size_t i;
+	if (addr_index) {
+		size_t lo = 0, hi = addr_index_cnt, mid;
+		while (lo < hi) {
+			mid = lo + (hi-lo)/2;
+			if (addr_index[mid].start <= a) lo = mid+1;
+			else hi = mid;
+		}
+		if (lo && a < addr_index[lo-1].end)
+			return addr_index[lo-1].dso;
+		return 0;
+	}
 	if (DL_FDPIC) for (p=head; p; p=p->next) {
 		i = count_syms(p);
 		if (a-(size_t)p->funcdescs < i*sizeof(*p->funcdescs))
@@ -2291,11 +3213,49 @@ static void *do_dlsym(struct dso *p, const char *s, void *ra)
 	return laddr(def.dso, def.sym->st_value);
 }
 
+static int sym_addr_cmp(const void *a, const void *b)
+{
+	const struct sym_addr *x = a, *y = b;
+	if (x->addr != y->addr) return x->addr < y->addr ? -1 : 1;
+	return x->sym < y->sym ? -1 : x->sym > y->sym;
+}
+
+/* Symbols eligible for dladdr sorted by address, built on first use.
+ * The first entry holds the count. Since dladdr may be called from a
+ * signal handler, this uses mmap rather than malloc. */
+static struct sym_addr *sym_addr_table(struct dso *p)
+{
+	struct sym_addr *t = p->sym_addrs, *old;
+	Sym *sym = p->syms;
+	size_t i, n, nsym, len;
+
+	if (t) return t;
+	nsym = count_syms(p);
+	len = (nsym+1) * sizeof *t;
+	t = mmap(0, len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (t == MAP_FAILED) return 0;
+	for (i=0, n=1; i<nsym; i++) {
+		if (sym[i].st_value
+		 && (1<<(sym[i].st_info&0xf) & OK_TYPES)
+		 && (1<<(sym[i].st_info>>4) & OK_BINDS))
+			t[n++] = (struct sym_addr){
+				(size_t)laddr(p, sym[i].st_value), sym+i };
+	}
+	qsort(t+1, n-1, sizeof *t, sym_addr_cmp);
+	t[0].addr = n-1;
+	if ((old = a_cas_p(&p->sym_addrs, 0, t))) {
+		munmap(t, len);
+		return old;
+	}
+	return t;
+}
+
 int dladdr(const void *addr_arg, Dl_info *info)
 {
 	size_t addr = (size_t)addr_arg;
 	struct dso *p;
 	Sym *sym, *bestsym;
+	struct sym_addr *t;
 	uint32_t nsym;
 	char *strings;
 	size_t best = 0;
@@ -2321,7 +3281,22 @@ int dladdr(const void *addr_arg, Dl_info *info)
 		}
 	}
 
-	if (!best) for (; nsym; nsym--, sym++) {
+	if (!best && (t = sym_addr_table(p))) {
+		size_t lo = 1, hi = t[0].addr+1, mid;
+		while (lo < hi) {
+			mid = lo + (hi-lo)/2;
+			if (t[mid].addr <= addr) lo = mid+1;
+			else hi = mid;
+		}
+		/* As with a linear scan, the first symbol in table order
+		 * among those at the nearest address wins. */
+		while (lo > 2 && t[lo-2].addr == t[lo-1].addr) lo--;
+		if (lo > 1) {
+			best = t[lo-1].addr;
+			bestsym = t[lo-1].sym;
+			besterr = addr - best;
+		}
+	} else if (!best) for (; nsym; nsym--, sym++) {
 		if (sym->st_value
 		 && (1<<(sym->st_info&0xf) & OK_TYPES)
 		 && (1<<(sym->st_info>>4) & OK_BINDS)) {
@@ -2394,11 +3369,34 @@ no_redir:
 	return __dlsym(p, s, ra);
 }
 
+const struct dl_phdr_snapshot *dl_phdr_snapshot_get(void)
+{
+	const struct dl_phdr_snapshot *s = phdr_snapshot;
+	if (!s) {
+		pthread_rwlock_wrlock(&lock);
+		if (!(s = phdr_snapshot)) update_phdr_snapshot();
+		s = phdr_snapshot;
+		pthread_rwlock_unlock(&lock);
+	}
+	return s;
+}
+
 int dl_iterate_phdr(int(*callback)(struct dl_phdr_info *info, size_t size, void *data), void *data)
 {
+	const struct dl_phdr_snapshot *s = phdr_snapshot;
 	struct dso *current;
 	struct dl_phdr_info info;
+	size_t i;
 	int ret = 0;
+	if (s) for (i=0; i<s->dlps_count; i++) {
+		info = s->dlps_info[i];
+		info.dlpi_adds = s->dlps_adds;
+		if (info.dlpi_tls_modid) info.dlpi_tls_data = __tls_get_addr(
+			(tls_mod_off_t[]){info.dlpi_tls_modid,0});
+		ret = (callback)(&info, sizeof (info), data);
+		if (ret != 0) return ret;
+	}
+	if (s) return 0;
 	for(current = head; current;) {
 		info.dlpi_addr      = (uintptr_t)current->base;
 		info.dlpi_name      = current->name;
@@ -15,6 +15,9 @@ int __init_tp(void *p)
 {
 	pthread_t td = p;
 	td->self = td;
+	/* When the dynamic linker moves the main thread to its final
+	 * TLS area, drop the registration of the early one. */
+	if (libc.can_do_threads) __rseq_unregister(__pthread_self());
 	int r = __set_thread_area(TP_ADJ(p));
 	if (r < 0) return -1;
 	if (!r) libc.can_do_threads = 1;
@@ -24,6 +27,7 @@ int __init_tp(void *p)
 	td->robust_list.head = &td->robust_list.head;
 	td->sysinfo = __sysinfo;
 	td->next = td->prev = td;
+	__rseq_register(td);
 	return 0;
 }
 
@@ -121,6 +125,7 @@ static void static_init_tls(size_t *aux)
 	main_tls.offset = main_tls.size;
 #endif
 	if (main_tls.align < MIN_TLS_ALIGN) main_tls.align = MIN_TLS_ALIGN;
+	if (main_tls.align < RSEQ_ALIGN) main_tls.align = RSEQ_ALIGN;
 
 	libc.tls_align = main_tls.align;
 	libc.tls_size = 2*sizeof(void *) + sizeof(struct pthread)
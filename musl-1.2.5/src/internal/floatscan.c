@@ -33,6 +33,9 @@
 
 #define MASK (KMAX-1)
 
+static const int p10s[] = { 10, 100, 1000, 10000,
+	100000, 1000000, 10000000, 100000000 };
+
 static long long scanexp(FILE *f, int pok)
 {
 	int c;
@@ -76,8 +79,6 @@ static long double decfloat(FILE *f, int c, int bits, int emin, int sign, int po
 	long double y;
 	long double frac=0;
 	long double bias=0;
-	static const int p10s[] = { 10, 100, 1000, 10000,
-		100000, 1000000, 10000000, 100000000 };
 
 	j=0;
 	k=0;
@@ -423,6 +424,83 @@ static long double hexfloat(FILE *f, int bits, int emin, int sign, int pok)
 	return scalbnl(y, e2);
 }
 
+/* Scan a plain decimal number lying entirely within the buffer of a
+ * real FILE straight from rpos, for use by vfscanf. Only the inputs
+ * for which decfloat takes one of its shortcuts are accepted, and the
+ * result is computed with the same expressions, so it is identical.
+ * Otherwise nothing is consumed and 0 is returned. */
+int __floatscan_buf(FILE *f, int prec, long double *y)
+{
+	const unsigned char *s = f->rpos, *e = f->rend;
+	uint32_t x = 0;
+	long long lrp = 0, dc = 0;
+	int lnz = 0, gotdig = 0, gotrad = 0;
+	int sign = 1;
+	int bits, rp, i;
+
+	switch (prec) {
+	case 0:
+		bits = FLT_MANT_DIG;
+		break;
+	case 1:
+		bits = DBL_MANT_DIG;
+		break;
+	case 2:
+		bits = LDBL_MANT_DIG;
+		break;
+	default:
+		return 0;
+	}
+
+	if (s<e && (*s=='+' || *s=='-')) sign -= 2*(*s++=='-');
+	if (e-s>1 && *s=='0' && (s[1]|32)=='x') return 0;
+
+	for (; s<e && *s=='0'; s++) gotdig=1;
+	if (s<e && *s=='.') {
+		gotrad = 1;
+		for (s++; s<e && *s=='0'; s++) gotdig=1, lrp--;
+	}
+	for (; s<e && (*s-'0'<10U || *s=='.'); s++) {
+		if (*s == '.') {
+			if (gotrad) return 0;
+			gotrad = 1;
+			lrp = dc;
+		} else {
+			dc++;
+			if (*s!='0') {
+				if (dc > 9) return 0;
+				lnz = dc;
+			}
+			if (dc <= 9) x = x*10 + *s-'0';
+			gotdig = 1;
+		}
+	}
+	if (!gotrad) lrp=dc;
+	if (!gotdig || s==e || (*s|32)=='e') return 0;
+
+	if (!x) {
+		*y = sign * 0.0;
+	} else if (lrp==dc && dc<10 && (bits>30 || x>>bits==0)) {
+		*y = sign * (long double)x;
+	} else {
+		for (i=dc; i<9; i++) x*=10;
+		rp = lrp;
+		if (!(lnz<9 && lnz<=rp && rp < 18)) return 0;
+		if (rp == 9) {
+			*y = sign * (long double)x;
+		} else if (rp < 9) {
+			*y = sign * (long double)x / p10s[8-rp];
+		} else {
+			int bitlim = bits-3*(int)(rp-9);
+			if (!(bitlim>30 || x>>bitlim==0)) return 0;
+			*y = sign * (long double)x * p10s[rp-10];
+		}
+	}
+
+	f->rpos = (void *)s;
+	return 1;
+}
+
 long double __floatscan(FILE *f, int prec, int pok)
 {
 	int sign = 1;
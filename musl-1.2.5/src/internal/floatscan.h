@@ -4,5 +4,6 @@
 #include <stdio.h>
 
 hidden long double __floatscan(FILE *, int, int);
+hidden int __floatscan_buf(FILE *, int, long double *);
 
 #endif
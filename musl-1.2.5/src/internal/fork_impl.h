@@ -6,7 +6,7 @@ extern hidden volatile int *const __gettext_lockptr;
 extern hidden volatile int *const __locale_lockptr;
 extern hidden volatile int *const __random_lockptr;
 extern hidden volatile int *const __sem_open_lockptr;
-extern hidden volatile int *const __stdio_ofl_lockptr;
+extern hidden volatile int *const __stack_cache_lockptr;
 extern hidden volatile int *const __syslog_lockptr;
 extern hidden volatile int *const __timezone_lockptr;
 
@@ -14,6 +14,7 @@ extern hidden volatile int *const __bump_lockptr;
 
 extern hidden volatile int *const __vmlock_lockptr;
 
+hidden void __ofl_atfork(int);
 hidden void __malloc_atfork(int);
 hidden void __ldso_atfork(int);
 hidden void __pthread_key_atfork(int);
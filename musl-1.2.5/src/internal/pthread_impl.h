@@ -5,6 +5,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <limits.h>
+#include <stddef.h>
 #include <sys/mman.h>
 #include "libc.h"
 #include "syscall.h"
@@ -58,6 +59,7 @@ struct pthread {
 	volatile int killlock[1];
 	char *dlerror_buf;
 	void *stdio_locks;
+	char rseq_area[64];
 
 	/* Part 3 -- the positions of these fields relative to
 	 * the end of the structure is external and internal ABI. */
@@ -99,6 +101,11 @@ enum {
 #define _rw_lock __u.__vi[0]
 #define _rw_waiters __u.__vi[1]
 #define _rw_shared __u.__i[2]
+#define _rw_kind __u.__i[3]
+#define _rw_owner __u.__i[4]
+#define _rw_mask __u.__i[5]
+#define _rw_slots __u.__p[6]
+#define _rw_wwaiters __u.__vi[7]
 #define _b_lock __u.__vi[0]
 #define _b_waiters __u.__vi[1]
 #define _b_limit __u.__i[2]
@@ -122,6 +129,30 @@ enum {
 #define __pthread_self() ((pthread_t)__get_tp())
 #endif
 
+/* Restartable sequences area registered with the kernel, layout per
+ * linux/rseq.h. It must be 32-byte aligned and at a fixed offset from
+ * the thread pointer, so it is placed within rseq_area relative to the
+ * end of struct pthread which the TLS layout keeps aligned. */
+struct rseq_area {
+	volatile unsigned cpu_id_start;
+	volatile int cpu_id;
+	volatile unsigned long long rseq_cs;
+	volatile unsigned flags, node_id, mm_cid, pad;
+};
+
+#define RSEQ_ALIGN 32
+#ifdef TLS_ABOVE_TP
+#define RSEQ_OFF (sizeof(struct pthread) - (sizeof(struct pthread) \
+	- offsetof(struct pthread, rseq_area) & -RSEQ_ALIGN))
+#else
+#define RSEQ_OFF (offsetof(struct pthread, rseq_area) + RSEQ_ALIGN-1 & -RSEQ_ALIGN)
+#endif
+
+static inline struct rseq_area *__rseq_area(pthread_t t)
+{
+	return (void *)((char *)t + RSEQ_OFF);
+}
+
 #ifndef tls_mod_off_t
 #define tls_mod_off_t size_t
 #endif
@@ -145,6 +176,8 @@ hidden void __reset_tls();
 
 hidden void __membarrier_init(void);
 hidden void __dl_thread_cleanup(void);
+hidden int __rseq_register(pthread_t);
+hidden void __rseq_unregister(pthread_t);
 hidden void __testcancel();
 hidden void __do_cleanup_push(struct __ptcb *);
 hidden void __do_cleanup_pop(struct __ptcb *);
@@ -187,8 +220,27 @@ hidden void __tl_lock(void);
 hidden void __tl_unlock(void);
 hidden void __tl_sync(pthread_t);
 
+hidden int __stack_cache_put(pthread_t);
+
+/* Reader indicators of a distributed rwlock, one cache line each.
+ * Threads are spread across them by tid; the lock word then only
+ * ever carries the write lock. */
+struct rw_slot {
+	volatile int cnt, waiters;
+	char pad[64-2*sizeof(int)];
+};
+
+static inline struct rw_slot *__rw_slot(pthread_rwlock_t *rw)
+{
+	return (struct rw_slot *)rw->_rw_slots
+		+ (__pthread_self()->tid & rw->_rw_mask);
+}
+
 extern hidden volatile int __thread_list_lock;
 
+extern hidden volatile int __lockstat_on;
+hidden void __lockstat_record(volatile int *, int, long long);
+
 extern hidden volatile int __abort_lock[1];
 
 extern hidden unsigned __default_stacksize;
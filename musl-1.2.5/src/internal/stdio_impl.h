@@ -81,7 +81,10 @@ hidden int __putc_unlocked(int, FILE *);
 hidden FILE *__fdopen(int, const char *);
 hidden int __fmodeflags(const char *);
 
+#define OFL_SHARDS 16
+
 hidden FILE *__ofl_add(FILE *f);
+hidden void __ofl_del(FILE *f);
 hidden FILE **__ofl_lock(void);
 hidden void __ofl_unlock(void);
 
@@ -45,3 +45,24 @@ static int static_dl_iterate_phdr(int(*callback)(struct dl_phdr_info *info, size
 }
 
 weak_alias(static_dl_iterate_phdr, dl_iterate_phdr);
+
+static int copy_info(struct dl_phdr_info *info, size_t size, void *data)
+{
+	*(struct dl_phdr_info *)data = *info;
+	return 0;
+}
+
+static const struct dl_phdr_snapshot *static_dl_phdr_snapshot_get(void)
+{
+	static struct dl_phdr_info info;
+	static struct dl_phdr_snapshot snap = { .dlps_info = &info };
+	if (!snap.dlps_count) {
+		static_dl_iterate_phdr(copy_info, &info);
+		info.dlpi_tls_data = 0;
+		a_barrier();
+		snap.dlps_count = 1;
+	}
+	return &snap;
+}
+
+weak_alias(static_dl_phdr_snapshot_get, dl_phdr_snapshot_get);
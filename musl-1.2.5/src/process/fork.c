@@ -13,7 +13,7 @@ weak_alias(dummy_lockptr, __gettext_lockptr);
 weak_alias(dummy_lockptr, __locale_lockptr);
 weak_alias(dummy_lockptr, __random_lockptr);
 weak_alias(dummy_lockptr, __sem_open_lockptr);
-weak_alias(dummy_lockptr, __stdio_ofl_lockptr);
+weak_alias(dummy_lockptr, __stack_cache_lockptr);
 weak_alias(dummy_lockptr, __syslog_lockptr);
 weak_alias(dummy_lockptr, __timezone_lockptr);
 weak_alias(dummy_lockptr, __bump_lockptr);
@@ -27,7 +27,7 @@ static volatile int *const *const atfork_locks[] = {
 	&__locale_lockptr,
 	&__random_lockptr,
 	&__sem_open_lockptr,
-	&__stdio_ofl_lockptr,
+	&__stack_cache_lockptr,
 	&__syslog_lockptr,
 	&__timezone_lockptr,
 	&__bump_lockptr,
@@ -35,6 +35,7 @@ static volatile int *const *const atfork_locks[] = {
 
 static void dummy(int x) { }
 weak_alias(dummy, __fork_handler);
+weak_alias(dummy, __ofl_atfork);
 weak_alias(dummy, __malloc_atfork);
 weak_alias(dummy, __aio_atfork);
 weak_alias(dummy, __pthread_key_atfork);
@@ -57,6 +58,7 @@ pid_t fork(void)
 		__inhibit_ptc();
 		for (int i=0; i<sizeof atfork_locks/sizeof *atfork_locks; i++)
 			if (*atfork_locks[i]) LOCK(*atfork_locks[i]);
+		__ofl_atfork(-1);
 		__malloc_atfork(-1);
 		__tl_lock();
 	}
@@ -74,6 +76,7 @@ pid_t fork(void)
 		}
 		__tl_unlock();
 		__malloc_atfork(!ret);
+		__ofl_atfork(!ret);
 		for (int i=0; i<sizeof atfork_locks/sizeof *atfork_locks; i++)
 			if (*atfork_locks[i])
 				if (ret) UNLOCK(*atfork_locks[i]);
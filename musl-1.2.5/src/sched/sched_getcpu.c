@@ -3,6 +3,7 @@
 #include <sched.h>
 #include "syscall.h"
 #include "atomic.h"
+#include "pthread_impl.h"
 
 #ifdef VDSO_GETCPU_SYM
 
@@ -27,6 +28,11 @@ int sched_getcpu(void)
 	int r;
 	unsigned cpu;
 
+	/* The kernel keeps the registered rseq area current on every
+	 * return to userspace, so no call is needed at all. */
+	r = __rseq_area(__pthread_self())->cpu_id;
+	if (r >= 0) return r;
+
 #ifdef VDSO_GETCPU_SYM
 	getcpu_f f = (getcpu_f)vdso_func;
 	if (f) {
@@ -15,8 +15,9 @@ static void close_file(FILE *f)
 
 void __stdio_exit(void)
 {
-	FILE *f;
-	for (f=*__ofl_lock(); f; f=f->next) close_file(f);
+	FILE *f, **ofl = __ofl_lock();
+	for (int i=0; i<OFL_SHARDS; i++)
+		for (f=ofl[i]; f; f=f->next) close_file(f);
 	close_file(__stdin_used);
 	close_file(__stdout_used);
 	close_file(__stderr_used);
@@ -25,11 +25,7 @@ int fclose(FILE *f)
 
 	__unlist_locked_file(f);
 
-	FILE **head = __ofl_lock();
-	if (f->prev) f->prev->next = f->next;
-	if (f->next) f->next->prev = f->prev;
-	if (*head == f) *head = f->next;
-	__ofl_unlock();
+	__ofl_del(f);
 
 	free(f->getln_buf);
 	free(f);
@@ -8,11 +8,13 @@ weak_alias(dummy, __stderr_used);
 int fflush(FILE *f)
 {
 	if (!f) {
-		int r = 0;
+		int r = 0, i;
+		FILE **ofl;
 		if (__stdout_used) r |= fflush(__stdout_used);
 		if (__stderr_used) r |= fflush(__stderr_used);
 
-		for (f=*__ofl_lock(); f; f=f->next) {
+		ofl = __ofl_lock();
+		for (i=0; i<OFL_SHARDS; i++) for (f=ofl[i]; f; f=f->next) {
 			FLOCK(f);
 			if (f->wpos != f->wbase) r |= fflush(f);
 			FUNLOCK(f);
@@ -0,0 +1,111 @@
+#define _GNU_SOURCE
+#include "stdio_impl.h"
+#include "pthread_impl.h"
+#include <sys/uio.h>
+
+#define BATCH 64
+
+/* Only ever called while already holding another FILE lock, so it
+ * must not block; a busy FILE is simply left for its own turn. */
+static int trylock(FILE *f)
+{
+	int tid;
+	if (f->lock < 0) return 0;
+	tid = __pthread_self()->tid;
+	if ((f->lock & ~MAYBE_WAITERS) == tid) return 0;
+	return a_cas(&f->lock, 0, tid) ? -1 : 1;
+}
+
+static int write_batch(int fd, FILE **fs, struct iovec *iov, int cnt)
+{
+	ssize_t r;
+	int i = 0, err = 0;
+
+	while (i < cnt) {
+		r = syscall(SYS_writev, fd, iov+i, cnt-i);
+		if (r < 0) {
+			err = 1;
+			break;
+		}
+		for (; i<cnt && r >= iov[i].iov_len; i++) {
+			r -= iov[i].iov_len;
+			iov[i].iov_len = 0;
+		}
+		if (i < cnt) {
+			iov[i].iov_base = (char *)iov[i].iov_base + r;
+			iov[i].iov_len -= r;
+		}
+	}
+
+	/* As in __stdio_write, a buffer that could not be written out
+	 * in full is discarded and its stream put in the error state. */
+	for (i=0; i<cnt; i++) {
+		FILE *f = fs[i];
+		if (iov[i].iov_len) {
+			f->wpos = f->wbase = f->wend = 0;
+			f->flags |= F_ERR;
+		} else {
+			f->wend = f->buf + f->buf_size;
+			f->wpos = f->wbase = f->buf;
+		}
+	}
+	return err;
+}
+
+int fflushv(FILE *const *fs, size_t n)
+{
+	FILE *batch[BATCH];
+	struct iovec iov[BATCH];
+	char need_unlock[BATCH];
+	size_t i, j;
+	int r = 0, cnt, k, need, fd;
+
+	/* First pass: gather the pending output of fd-backed streams
+	 * sharing a file descriptor and write it out with one writev.
+	 * Streams join a batch in array order, and a busy stream on the
+	 * same fd ends the batch rather than being overtaken; it gets
+	 * its own turn later in the loop. */
+	for (i=0; i<n; i++) {
+		FILE *f = fs[i];
+		if (!f) continue;
+		need = f->lock>=0 ? __lockfile(f) : 0;
+		if (f->write != __stdio_write || f->wpos == f->wbase) {
+			if (need) __unlockfile(f);
+			continue;
+		}
+		fd = f->fd;
+		batch[0] = f;
+		iov[0].iov_base = f->wbase;
+		iov[0].iov_len = f->wpos - f->wbase;
+		need_unlock[0] = need;
+		cnt = 1;
+		for (j=i+1; j<n && cnt<BATCH; j++) {
+			FILE *g = fs[j];
+			if (!g || g->fd != fd) continue;
+			for (k=0; k<cnt && batch[k]!=g; k++);
+			if (k<cnt) continue;
+			need = trylock(g);
+			if (need < 0) break;
+			if (g->write != __stdio_write || g->wpos == g->wbase) {
+				if (need) __unlockfile(g);
+				continue;
+			}
+			batch[cnt] = g;
+			iov[cnt].iov_base = g->wbase;
+			iov[cnt].iov_len = g->wpos - g->wbase;
+			need_unlock[cnt] = need;
+			cnt++;
+		}
+		if (write_batch(fd, batch, iov, cnt)) r = EOF;
+		for (k=0; k<cnt; k++)
+			if (need_unlock[k]) __unlockfile(batch[k]);
+	}
+
+	/* Second pass: anything left pending (custom write functions)
+	 * plus the read-side position sync gets the ordinary fflush
+	 * treatment. */
+	for (i=0; i<n; i++)
+		if (fs[i] && fflush(fs[i])) r = EOF;
+
+	return r;
+}
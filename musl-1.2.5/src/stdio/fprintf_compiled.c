@@ -0,0 +1,13 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdarg.h>
+
+int fprintf_compiled(FILE *restrict f, const struct printf_format *restrict pf, ...)
+{
+	int ret;
+	va_list ap;
+	va_start(ap, pf);
+	ret = vfprintf_compiled(f, pf, ap);
+	va_end(ap);
+	return ret;
+}
@@ -0,0 +1,146 @@
+#define _GNU_SOURCE
+#include "stdio_impl.h"
+#include <errno.h>
+
+#define CHUNK 0x7ffff000
+
+/* Move up to len bytes of data already buffered in f to either the
+ * stream out or, if out is null, the file descriptor fd. */
+static size_t drain(FILE *out, int fd, FILE *in, size_t len)
+{
+	size_t k = in->rend - in->rpos, cnt = 0;
+	ssize_t r;
+	if (k > len) k = len;
+	if (out) {
+		cnt = __fwritex(in->rpos, k, out);
+	} else while (cnt < k) {
+		r = syscall(SYS_write, fd, in->rpos+cnt, k-cnt);
+		if (r < 0) break;
+		cnt += r;
+	}
+	in->rpos += cnt;
+	return cnt;
+}
+
+static int unsupported(long r)
+{
+	return r==-EINVAL || r==-EXDEV || r==-ENOSYS || r==-EBADF
+		|| r==-EOPNOTSUPP || r==-ESPIPE;
+}
+
+/* Transfer between the underlying descriptors, trying each of the
+ * kernel copy paths in turn. Returns 1 at end of input, 0 when len
+ * bytes were moved, -1 on error, and -2 if no path applies and
+ * nothing was transferred, in which case the caller falls back to
+ * copying through the buffer. */
+static int kcopy(int ofd, int ifd, size_t len, size_t *cnt)
+{
+	size_t k, start = *cnt;
+	long r;
+	int i = 0;
+
+	while (*cnt < len) {
+		k = len-*cnt < CHUNK ? len-*cnt : CHUNK;
+		switch (i) {
+		case 0:
+			r = __syscall(SYS_copy_file_range, ifd, 0, ofd, 0, k, 0);
+			break;
+		case 1:
+			r = __syscall(SYS_sendfile, ofd, ifd, 0, k);
+			break;
+		default:
+			r = __syscall(SYS_splice, ifd, 0, ofd, 0, k, 0);
+		}
+		if (r > 0) {
+			*cnt += r;
+			continue;
+		}
+		if (!r) return 1;
+		if (*cnt == start && unsupported(r)) {
+			if (++i < 3) continue;
+			return -2;
+		}
+		errno = -r;
+		return -1;
+	}
+	return 0;
+}
+
+static size_t copy(FILE *out, int ofd, FILE *in, size_t len)
+{
+	size_t cnt = 0;
+	int c;
+
+	in->mode |= in->mode-1;
+	if (in->rpos != in->rend) {
+		cnt = drain(out, ofd, in, len);
+		if (cnt == len || in->rpos != in->rend) return cnt;
+	}
+
+	/* With the read buffer empty, the position of the underlying
+	 * descriptor of in matches the stream position. Once any output
+	 * pending in out is written, the same holds for out and the bulk
+	 * of the data can be moved by the kernel. */
+	if (__toread(in)) return cnt;
+	if (out) {
+		if (out->write != __stdio_write && out->write != __stdout_write)
+			goto buffered;
+		if (!out->wend && __towrite(out)) return cnt;
+		if (out->wpos != out->wbase) {
+			out->write(out, 0, 0);
+			if (!out->wpos) return cnt;
+		}
+		ofd = out->fd;
+	}
+	if (in->read != __stdio_read) goto buffered;
+
+	switch (kcopy(ofd, in->fd, len, &cnt)) {
+	case 1:
+		in->flags |= F_EOF;
+		return cnt;
+	case -1:
+		in->flags |= F_ERR;
+		if (out) out->flags |= F_ERR;
+	case 0:
+		return cnt;
+	}
+
+buffered:
+	while (cnt < len) {
+		if ((c = getc_unlocked(in)) == EOF) break;
+		ungetc(c, in);
+		cnt += drain(out, ofd, in, len-cnt);
+		if (in->rpos != in->rend && cnt < len) break;
+	}
+	return cnt;
+}
+
+size_t fsendfile(FILE *restrict out, FILE *restrict in, size_t len)
+{
+	FILE *a = out < in ? out : in, *b = out < in ? in : out;
+	int need_a, need_b;
+	size_t cnt;
+
+	if (out == in) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	/* Lock in address order so concurrent copies in opposite
+	 * directions between the same two streams cannot deadlock. */
+	need_a = a->lock>=0 ? __lockfile(a) : 0;
+	need_b = b->lock>=0 ? __lockfile(b) : 0;
+	cnt = copy(out, -1, in, len);
+	if (need_b) __unlockfile(b);
+	if (need_a) __unlockfile(a);
+	return cnt;
+}
+
+size_t fsendfile_fd(int fd, FILE *restrict in, size_t len)
+{
+	size_t cnt;
+	FLOCK(in);
+	cnt = copy(0, fd, in, len);
+	FUNLOCK(in);
+	return cnt;
+}
@@ -0,0 +1,36 @@
+#define _GNU_SOURCE
+#include "stdio_impl.h"
+#include <string.h>
+#include <errno.h>
+
+ssize_t getdelim_slice(const char **restrict line, char **restrict s, size_t *restrict n, int delim, FILE *restrict f)
+{
+	unsigned char *z;
+	ssize_t l;
+
+	FLOCK(f);
+
+	if (!line || !s || !n) {
+		f->mode |= f->mode-1;
+		f->flags |= F_ERR;
+		FUNLOCK(f);
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Make sure there is buffered input to search, then hand out
+	 * the delimited record in place if it lies entirely within the
+	 * buffer. Only records straddling a refill are copied into the
+	 * caller's buffer, which getdelim grows as needed. */
+	if (f->rpos == f->rend) ungetc(getc_unlocked(f), f);
+	if (f->rend && (z=memchr(f->rpos, delim, f->rend - f->rpos))) {
+		*line = (const char *)f->rpos;
+		l = ++z - f->rpos;
+		f->rpos = z;
+	} else if ((l = getdelim(s, n, delim, f)) >= 0) {
+		*line = *s;
+	}
+
+	FUNLOCK(f);
+	return l;
+}
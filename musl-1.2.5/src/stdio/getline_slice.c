@@ -0,0 +1,7 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+
+ssize_t getline_slice(const char **restrict line, char **restrict s, size_t *restrict n, FILE *restrict f)
+{
+	return getdelim_slice(line, s, n, '\n', f);
+}
@@ -1,18 +1,58 @@
 #include "stdio_impl.h"
 #include "lock.h"
 #include "fork_impl.h"
+#include <stdint.h>
 
-static FILE *ofl_head;
-static volatile int ofl_lock[1];
-volatile int *const __stdio_ofl_lockptr = ofl_lock;
+/* The open file list is split into shards, each with its own lock,
+ * so that threads opening and closing unrelated files do not contend.
+ * Operations on the list as a whole take every shard lock, in order. */
+
+static FILE *ofl_head[OFL_SHARDS];
+static struct {
+	volatile int lock[1];
+	char pad[64-sizeof(int)];
+} ofl_lock[OFL_SHARDS];
+
+static int shard(FILE *f)
+{
+	return ((uint32_t)((uintptr_t)f >> 4) * 0x9e3779b1 >> 16) % OFL_SHARDS;
+}
 
 FILE **__ofl_lock()
 {
-	LOCK(ofl_lock);
-	return &ofl_head;
+	for (int i=0; i<OFL_SHARDS; i++) LOCK(ofl_lock[i].lock);
+	return ofl_head;
 }
 
 void __ofl_unlock()
 {
-	UNLOCK(ofl_lock);
+	for (int i=OFL_SHARDS-1; i>=0; i--) UNLOCK(ofl_lock[i].lock);
+}
+
+FILE *__ofl_add(FILE *f)
+{
+	int i = shard(f);
+	LOCK(ofl_lock[i].lock);
+	f->next = ofl_head[i];
+	if (ofl_head[i]) ofl_head[i]->prev = f;
+	ofl_head[i] = f;
+	UNLOCK(ofl_lock[i].lock);
+	return f;
+}
+
+void __ofl_del(FILE *f)
+{
+	int i = shard(f);
+	LOCK(ofl_lock[i].lock);
+	if (f->prev) f->prev->next = f->next;
+	if (f->next) f->next->prev = f->prev;
+	if (ofl_head[i] == f) ofl_head[i] = f->next;
+	UNLOCK(ofl_lock[i].lock);
+}
+
+void __ofl_atfork(int who)
+{
+	if (who<0) __ofl_lock();
+	else if (!who) __ofl_unlock();
+	else for (int i=0; i<OFL_SHARDS; i++) ofl_lock[i].lock[0] = 0;
 }
@@ -20,6 +20,34 @@ struct ms_FILE {
 	unsigned char buf[BUFSIZ];
 };
 
+/* Where possible, rather than using its own buffer, the FILE writes
+ * through a window onto the backing memory starting at the current
+ * position, leaving room for the null terminator. Seeking and growth
+ * move the window; the stdio core picks up the new one via __towrite.
+ * The FILE's own buffer is only used when no space is left, since
+ * vfprintf would otherwise treat the stream as unbuffered. */
+static void ms_window(FILE *f, struct cookie *c)
+{
+	if (c->pos + 1 < c->space) {
+		f->buf = (unsigned char *)c->buf + c->pos;
+		f->buf_size = c->space - c->pos - 1;
+	} else {
+		f->buf = ((struct ms_FILE *)f)->buf;
+		f->buf_size = BUFSIZ;
+	}
+}
+
+static void ms_commit(struct cookie *c, size_t len)
+{
+	if (c->pos > c->len) memset(c->buf+c->len, 0, c->pos-c->len);
+	c->pos += len;
+	if (c->pos >= c->len) {
+		c->len = c->pos;
+		c->buf[c->len] = 0;
+	}
+	*c->sizep = c->pos;
+}
+
 static off_t ms_seek(FILE *f, off_t off, int whence)
 {
 	ssize_t base;
@@ -31,7 +59,9 @@ fail:
 	}
 	base = (size_t [3]){0, c->pos, c->len}[whence];
 	if (off < -base || off > SSIZE_MAX-base) goto fail;
-	return c->pos = base+off;
+	c->pos = base+off;
+	ms_window(f, c);
+	return c->pos;
 }
 
 static size_t ms_write(FILE *f, const unsigned char *buf, size_t len)
@@ -41,20 +71,31 @@ static size_t ms_write(FILE *f, const unsigned char *buf, size_t len)
 	char *newbuf;
 	if (len2) {
 		f->wpos = f->wbase;
-		if (ms_write(f, f->wbase, len2) < len2) return 0;
+		if (f->wbase == (unsigned char *)c->buf + c->pos)
+			ms_commit(c, len2);
+		else if (ms_write(f, f->wbase, len2) < len2)
+			return 0;
 	}
 	if (len + c->pos >= c->space) {
 		len2 = 2*c->space+1 | c->pos+len+1;
+		if (len2 < BUFSIZ) len2 = BUFSIZ;
+		/* Large sizes are grown in place by realloc using mremap.
+		 * The new space is not cleared; ms_commit zero-fills any
+		 * gap left by seeking past the end when it is written. */
 		newbuf = realloc(c->buf, len2);
-		if (!newbuf) return 0;
+		if (!newbuf) {
+			ms_window(f, c);
+			f->wpos = f->wbase = f->wend = 0;
+			return 0;
+		}
 		*c->bufp = c->buf = newbuf;
-		memset(c->buf + c->space, 0, len2 - c->space);
 		c->space = len2;
 	}
 	memcpy(c->buf+c->pos, buf, len);
-	c->pos += len;
-	if (c->pos >= c->len) c->len = c->pos;
-	*c->sizep = c->pos;
+	ms_commit(c, len);
+	ms_window(f, c);
+	f->wpos = f->wbase = f->buf;
+	f->wend = f->buf + f->buf_size;
 	return len;
 }
 
@@ -85,8 +126,7 @@ FILE *open_memstream(char **bufp, size_t *sizep)
 
 	f->f.flags = F_NORD;
 	f->f.fd = -1;
-	f->f.buf = f->buf;
-	f->f.buf_size = sizeof f->buf;
+	ms_window(&f->f, &f->c);
 	f->f.lbf = EOF;
 	f->f.write = ms_write;
 	f->f.seek = ms_seek;
@@ -34,9 +34,11 @@ FILE *popen(const char *cmd, const char *mode)
 
 	e = ENOMEM;
 	if (!posix_spawn_file_actions_init(&fa)) {
-		for (FILE *l = *__ofl_lock(); l; l=l->next)
-			if (l->pipe_pid && posix_spawn_file_actions_addclose(&fa, l->fd))
-				goto fail;
+		FILE **ofl = __ofl_lock();
+		for (int i=0; i<OFL_SHARDS; i++)
+			for (FILE *l = ofl[i]; l; l=l->next)
+				if (l->pipe_pid && posix_spawn_file_actions_addclose(&fa, l->fd))
+					goto fail;
 		if (!posix_spawn_file_actions_adddup2(&fa, p[1-op], 1-op)) {
 			if (!(e = posix_spawn(&pid, "/bin/sh", &fa, 0,
 			    (char *[]){ "sh", "-c", (char *)cmd, 0 }, __environ))) {
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "stdio_impl.h"
 #include <errno.h>
 #include <ctype.h>
@@ -427,22 +428,252 @@ static int getint(char **s) {
 	return i;
 }
 
-static int printf_core(FILE *f, const char *fmt, va_list *ap, union arg *nl_arg, int *nl_type)
-{
-	char *a, *z, *s=(char *)fmt;
-	unsigned l10n=0, fl;
+/* A parsed conversion specification. For the field width and the
+ * precision, warg/parg is 0 if the value is given in the format, -1 if
+ * it is taken from the next argument, or the position of the argument
+ * it is taken from. */
+
+struct spec {
+	unsigned fl;
 	int w, p, xp;
-	union arg arg;
+	int warg, parg;
 	int argpos;
 	unsigned st, ps;
-	int cnt=0, l=0;
+	int t;
+};
+
+static int getspec(char **ps, struct spec *sp, unsigned *l10n)
+{
+	char *s = *ps;
+	unsigned fl, st;
+
+	if (isdigit(s[1]) && s[2]=='$') {
+		*l10n=1;
+		sp->argpos = s[1]-'0';
+		s+=3;
+	} else {
+		sp->argpos = -1;
+		s++;
+	}
+
+	/* Read modifier flags */
+	for (fl=0; (unsigned)*s-' '<32 && (FLAGMASK&(1U<<*s-' ')); s++)
+		fl |= 1U<<*s-' ';
+	sp->fl = fl;
+
+	/* Read field width */
+	if (*s=='*') {
+		if (isdigit(s[1]) && s[2]=='$') {
+			*l10n=1;
+			sp->warg = s[1]-'0';
+			s+=3;
+		} else if (!*l10n) {
+			sp->warg = -1;
+			s++;
+		} else goto inval;
+		sp->w = 0;
+	} else {
+		sp->warg = 0;
+		if ((sp->w=getint(&s))<0) goto overflow;
+	}
+
+	/* Read precision */
+	sp->parg = 0;
+	if (*s=='.' && s[1]=='*') {
+		if (isdigit(s[2]) && s[3]=='$') {
+			sp->parg = s[2]-'0';
+			s+=4;
+		} else if (!*l10n) {
+			sp->parg = -1;
+			s+=2;
+		} else goto inval;
+		sp->p = 0;
+	} else if (*s=='.') {
+		s++;
+		sp->p = getint(&s);
+		sp->xp = 1;
+	} else {
+		sp->p = -1;
+		sp->xp = 0;
+	}
+
+	/* Format specifier state machine */
+	st=0;
+	do {
+		if (OOB(*s)) goto inval;
+		sp->ps=st;
+		st=states[st]S(*s++);
+	} while (st-1<STOP);
+	if (!st) goto inval;
+	sp->st = st;
+	sp->t = s[-1];
+
+	/* Check validity of argument type (nl/normal) */
+	if (st==NOARG && sp->argpos>=0) goto inval;
+
+	*ps = s;
+	return 0;
+inval:
+	errno = EINVAL;
+	return -1;
+overflow:
+	errno = EOVERFLOW;
+	return -1;
+}
+
+/* Fetch the width, precision and argument for a specification. */
+
+static void getargs(const struct spec *sp, unsigned *fl, int *w, int *p, int *xp, union arg *arg, va_list *ap, union arg *nl_arg)
+{
+	*fl = sp->fl;
+	if (sp->warg) {
+		*w = sp->warg>0 ? nl_arg[sp->warg].i : va_arg(*ap, int);
+		if (*w<0) *fl|=LEFT_ADJ, *w=-*w;
+	} else *w = sp->w;
+	if (sp->parg) {
+		*p = sp->parg>0 ? nl_arg[sp->parg].i : va_arg(*ap, int);
+		*xp = (*p>=0);
+	} else *p = sp->p, *xp = sp->xp;
+	if (sp->st==NOARG) return;
+	if (sp->argpos>=0) *arg=nl_arg[sp->argpos];
+	else pop_arg(arg, sp->st, ap);
+}
+
+/* Format one conversion; cnt is the output count so far. Returns the
+ * length of the output, or -1 with errno set on error. */
+
+static int fmt_spec(FILE *f, union arg arg, unsigned fl, int w, int p, int xp, int t, unsigned ps, int cnt)
+{
+	char *a, *z;
+	int l, pl;
 	size_t i;
 	char buf[sizeof(uintmax_t)*3];
 	const char *prefix;
-	int t, pl;
 	wchar_t wc[2], *ws;
 	char mb[4];
 
+	z = buf + sizeof(buf);
+	prefix = "-+   0X0x";
+	pl = 0;
+
+	/* Transform ls,lc -> S,C */
+	if (ps && (t&15)==3) t&=~32;
+
+	/* - and 0 flags are mutually exclusive */
+	if (fl & LEFT_ADJ) fl &= ~ZERO_PAD;
+
+	switch(t) {
+	case 'n':
+		switch(ps) {
+		case BARE: *(int *)arg.p = cnt; break;
+		case LPRE: *(long *)arg.p = cnt; break;
+		case LLPRE: *(long long *)arg.p = cnt; break;
+		case HPRE: *(unsigned short *)arg.p = cnt; break;
+		case HHPRE: *(unsigned char *)arg.p = cnt; break;
+		case ZTPRE: *(size_t *)arg.p = cnt; break;
+		case JPRE: *(uintmax_t *)arg.p = cnt; break;
+		}
+		return 0;
+	case 'p':
+		p = MAX(p, 2*sizeof(void*));
+		t = 'x';
+		fl |= ALT_FORM;
+	case 'x': case 'X':
+		a = fmt_x(arg.i, z, t&32);
+		if (arg.i && (fl & ALT_FORM)) prefix+=(t>>4), pl=2;
+		if (0) {
+	case 'o':
+		a = fmt_o(arg.i, z);
+		if ((fl&ALT_FORM) && p<z-a+1) p=z-a+1;
+		} if (0) {
+	case 'd': case 'i':
+		pl=1;
+		if (arg.i>INTMAX_MAX) {
+			arg.i=-arg.i;
+		} else if (fl & MARK_POS) {
+			prefix++;
+		} else if (fl & PAD_POS) {
+			prefix+=2;
+		} else pl=0;
+	case 'u':
+		a = fmt_u(arg.i, z);
+		}
+		if (xp && p<0) goto overflow;
+		if (xp) fl &= ~ZERO_PAD;
+		if (!arg.i && !p) {
+			a=z;
+			break;
+		}
+		p = MAX(p, z-a + !arg.i);
+		break;
+	narrow_c:
+	case 'c':
+		*(a=z-(p=1))=arg.i;
+		fl &= ~ZERO_PAD;
+		break;
+	case 'm':
+		if (1) a = strerror(errno); else
+	case 's':
+		a = arg.p ? arg.p : "(null)";
+		z = a + strnlen(a, p<0 ? INT_MAX : p);
+		if (p<0 && *z) goto overflow;
+		p = z-a;
+		fl &= ~ZERO_PAD;
+		break;
+	case 'C':
+		if (!arg.i) goto narrow_c;
+		wc[0] = arg.i;
+		wc[1] = 0;
+		arg.p = wc;
+		p = -1;
+	case 'S':
+		ws = arg.p;
+		for (i=l=0; i<p && *ws && (l=wctomb(mb, *ws++))>=0 && l<=p-i; i+=l);
+		if (l<0) return -1;
+		if (i > INT_MAX) goto overflow;
+		p = i;
+		pad(f, ' ', w, p, fl);
+		ws = arg.p;
+		for (i=0; i<0U+p && *ws && i+(l=wctomb(mb, *ws++))<=p; i+=l)
+			out(f, mb, l);
+		pad(f, ' ', w, p, fl^LEFT_ADJ);
+		return w>p ? w : p;
+	case 'e': case 'f': case 'g': case 'a':
+	case 'E': case 'F': case 'G': case 'A':
+		if (xp && p<0) goto overflow;
+		l = fmt_fp(f, arg.f, w, p, fl, t);
+		if (l<0) goto overflow;
+		return l;
+	}
+
+	if (p < z-a) p = z-a;
+	if (p > INT_MAX-pl) goto overflow;
+	if (w < pl+p) w = pl+p;
+	if (w > INT_MAX-cnt) goto overflow;
+
+	pad(f, ' ', w, pl+p, fl);
+	out(f, prefix, pl);
+	pad(f, '0', w, pl+p, fl^ZERO_PAD);
+	pad(f, '0', p, z-a, 0);
+	out(f, a, z-a);
+	pad(f, ' ', w, pl+p, fl^LEFT_ADJ);
+
+	return w;
+overflow:
+	errno = EOVERFLOW;
+	return -1;
+}
+
+static int printf_core(FILE *f, const char *fmt, va_list *ap, union arg *nl_arg, int *nl_type)
+{
+	char *a, *z, *s=(char *)fmt;
+	unsigned l10n=0, fl;
+	int w, p, xp;
+	union arg arg;
+	struct spec sp;
+	int cnt=0, l=0;
+	size_t i;
+
 	for (;;) {
 		/* This error is only specified for snprintf, but since it's
 		 * unspecified for other forms, do the same. Stop immediately
@@ -461,187 +692,24 @@ static int printf_core(FILE *f, const char *fmt, va_list *ap, union arg *nl_arg,
 		if (f) out(f, a, l);
 		if (l) continue;
 
-		if (isdigit(s[1]) && s[2]=='$') {
-			l10n=1;
-			argpos = s[1]-'0';
-			s+=3;
-		} else {
-			argpos = -1;
-			s++;
-		}
-
-		/* Read modifier flags */
-		for (fl=0; (unsigned)*s-' '<32 && (FLAGMASK&(1U<<*s-' ')); s++)
-			fl |= 1U<<*s-' ';
-
-		/* Read field width */
-		if (*s=='*') {
-			if (isdigit(s[1]) && s[2]=='$') {
-				l10n=1;
-				if (!f) nl_type[s[1]-'0'] = INT, w = 0;
-				else w = nl_arg[s[1]-'0'].i;
-				s+=3;
-			} else if (!l10n) {
-				w = f ? va_arg(*ap, int) : 0;
-				s++;
-			} else goto inval;
-			if (w<0) fl|=LEFT_ADJ, w=-w;
-		} else if ((w=getint(&s))<0) goto overflow;
-
-		/* Read precision */
-		if (*s=='.' && s[1]=='*') {
-			if (isdigit(s[2]) && s[3]=='$') {
-				if (!f) nl_type[s[2]-'0'] = INT, p = 0;
-				else p = nl_arg[s[2]-'0'].i;
-				s+=4;
-			} else if (!l10n) {
-				p = f ? va_arg(*ap, int) : 0;
-				s+=2;
-			} else goto inval;
-			xp = (p>=0);
-		} else if (*s=='.') {
-			s++;
-			p = getint(&s);
-			xp = 1;
-		} else {
-			p = -1;
-			xp = 0;
-		}
+		if (getspec(&s, &sp, &l10n)) return -1;
 
-		/* Format specifier state machine */
-		st=0;
-		do {
-			if (OOB(*s)) goto inval;
-			ps=st;
-			st=states[st]S(*s++);
-		} while (st-1<STOP);
-		if (!st) goto inval;
-
-		/* Check validity of argument type (nl/normal) */
-		if (st==NOARG) {
-			if (argpos>=0) goto inval;
-		} else {
-			if (argpos>=0) {
-				if (!f) nl_type[argpos]=st;
-				else arg=nl_arg[argpos];
-			} else if (f) pop_arg(&arg, st, ap);
-			else return 0;
+		if (!f) {
+			if (sp.warg>0) nl_type[sp.warg] = INT;
+			if (sp.parg>0) nl_type[sp.parg] = INT;
+			if (sp.st==NOARG) continue;
+			if (sp.argpos<0) return 0;
+			nl_type[sp.argpos] = sp.st;
+			continue;
 		}
 
-		if (!f) continue;
+		getargs(&sp, &fl, &w, &p, &xp, &arg, ap, nl_arg);
 
 		/* Do not process any new directives once in error state. */
 		if (ferror(f)) return -1;
 
-		z = buf + sizeof(buf);
-		prefix = "-+   0X0x";
-		pl = 0;
-		t = s[-1];
-
-		/* Transform ls,lc -> S,C */
-		if (ps && (t&15)==3) t&=~32;
-
-		/* - and 0 flags are mutually exclusive */
-		if (fl & LEFT_ADJ) fl &= ~ZERO_PAD;
-
-		switch(t) {
-		case 'n':
-			switch(ps) {
-			case BARE: *(int *)arg.p = cnt; break;
-			case LPRE: *(long *)arg.p = cnt; break;
-			case LLPRE: *(long long *)arg.p = cnt; break;
-			case HPRE: *(unsigned short *)arg.p = cnt; break;
-			case HHPRE: *(unsigned char *)arg.p = cnt; break;
-			case ZTPRE: *(size_t *)arg.p = cnt; break;
-			case JPRE: *(uintmax_t *)arg.p = cnt; break;
-			}
-			continue;
-		case 'p':
-			p = MAX(p, 2*sizeof(void*));
-			t = 'x';
-			fl |= ALT_FORM;
-		case 'x': case 'X':
-			a = fmt_x(arg.i, z, t&32);
-			if (arg.i && (fl & ALT_FORM)) prefix+=(t>>4), pl=2;
-			if (0) {
-		case 'o':
-			a = fmt_o(arg.i, z);
-			if ((fl&ALT_FORM) && p<z-a+1) p=z-a+1;
-			} if (0) {
-		case 'd': case 'i':
-			pl=1;
-			if (arg.i>INTMAX_MAX) {
-				arg.i=-arg.i;
-			} else if (fl & MARK_POS) {
-				prefix++;
-			} else if (fl & PAD_POS) {
-				prefix+=2;
-			} else pl=0;
-		case 'u':
-			a = fmt_u(arg.i, z);
-			}
-			if (xp && p<0) goto overflow;
-			if (xp) fl &= ~ZERO_PAD;
-			if (!arg.i && !p) {
-				a=z;
-				break;
-			}
-			p = MAX(p, z-a + !arg.i);
-			break;
-		narrow_c:
-		case 'c':
-			*(a=z-(p=1))=arg.i;
-			fl &= ~ZERO_PAD;
-			break;
-		case 'm':
-			if (1) a = strerror(errno); else
-		case 's':
-			a = arg.p ? arg.p : "(null)";
-			z = a + strnlen(a, p<0 ? INT_MAX : p);
-			if (p<0 && *z) goto overflow;
-			p = z-a;
-			fl &= ~ZERO_PAD;
-			break;
-		case 'C':
-			if (!arg.i) goto narrow_c;
-			wc[0] = arg.i;
-			wc[1] = 0;
-			arg.p = wc;
-			p = -1;
-		case 'S':
-			ws = arg.p;
-			for (i=l=0; i<p && *ws && (l=wctomb(mb, *ws++))>=0 && l<=p-i; i+=l);
-			if (l<0) return -1;
-			if (i > INT_MAX) goto overflow;
-			p = i;
-			pad(f, ' ', w, p, fl);
-			ws = arg.p;
-			for (i=0; i<0U+p && *ws && i+(l=wctomb(mb, *ws++))<=p; i+=l)
-				out(f, mb, l);
-			pad(f, ' ', w, p, fl^LEFT_ADJ);
-			l = w>p ? w : p;
-			continue;
-		case 'e': case 'f': case 'g': case 'a':
-		case 'E': case 'F': case 'G': case 'A':
-			if (xp && p<0) goto overflow;
-			l = fmt_fp(f, arg.f, w, p, fl, t);
-			if (l<0) goto overflow;
-			continue;
-		}
-
-		if (p < z-a) p = z-a;
-		if (p > INT_MAX-pl) goto overflow;
-		if (w < pl+p) w = pl+p;
-		if (w > INT_MAX-cnt) goto overflow;
-
-		pad(f, ' ', w, pl+p, fl);
-		out(f, prefix, pl);
-		pad(f, '0', w, pl+p, fl^ZERO_PAD);
-		pad(f, '0', p, z-a, 0);
-		out(f, a, z-a);
-		pad(f, ' ', w, pl+p, fl^LEFT_ADJ);
-
-		l = w;
+		if ((l = fmt_spec(f, arg, fl, w, p, xp, sp.t, sp.ps, cnt)) < 0)
+			return -1;
 	}
 
 	if (f) return cnt;
@@ -661,22 +729,130 @@ overflow:
 	return -1;
 }
 
-int vfprintf(FILE *restrict f, const char *restrict fmt, va_list ap)
+/* A format string compiled by printf_compile: the literal text and
+ * conversion specifications in order, with sp.st zero for literal text,
+ * followed in the same allocation by a copy of the format which the
+ * literal text points into. */
+
+struct printf_format {
+	unsigned l10n;
+	size_t n;
+	int nl_type[NL_ARGMAX+1];
+	struct {
+		const char *a;
+		int l;
+		struct spec sp;
+	} dir[];
+};
+
+static ssize_t compile(const char *fmt, struct printf_format *pf, int *nl_type, unsigned *l10n)
 {
-	va_list ap2;
+	char *a, *z, *s=(char *)fmt;
+	struct spec sp;
+	int seq=0;
+	size_t n, i;
+
+	for (n=0; *s; n++) {
+		for (a=s; *s && *s!='%'; s++);
+		for (z=s; s[0]=='%' && s[1]=='%'; z++, s+=2);
+		if (z-a > INT_MAX) goto overflow;
+		if (z-a) {
+			if (pf) {
+				pf->dir[n].a = a;
+				pf->dir[n].l = z-a;
+				pf->dir[n].sp.st = 0;
+			}
+			continue;
+		}
+		if (getspec(&s, &sp, l10n)) return -1;
+		if (sp.warg>0) nl_type[sp.warg] = INT;
+		if (sp.parg>0) nl_type[sp.parg] = INT;
+		if (sp.warg<0 || sp.parg<0) seq=1;
+		if (sp.st!=NOARG) {
+			if (sp.argpos<0) seq=1;
+			else nl_type[sp.argpos] = sp.st;
+		}
+		if (pf) pf->dir[n].sp = sp;
+	}
+
+	/* Unlike printf_core, reject mixing positional and sequential
+	 * arguments rather than leaving the behavior undefined. */
+	if (*l10n) {
+		if (seq) goto inval;
+		for (i=1; i<=NL_ARGMAX && nl_type[i]; i++);
+		for (; i<=NL_ARGMAX && !nl_type[i]; i++);
+		if (i<=NL_ARGMAX) goto inval;
+	}
+	return n;
+
+inval:
+	errno = EINVAL;
+	return -1;
+overflow:
+	errno = EOVERFLOW;
+	return -1;
+}
+
+struct printf_format *printf_compile(const char *fmt)
+{
+	struct printf_format *pf;
 	int nl_type[NL_ARGMAX+1] = {0};
-	union arg nl_arg[NL_ARGMAX+1];
+	unsigned l10n = 0;
+	ssize_t n = compile(fmt, 0, nl_type, &l10n);
+	size_t l = strlen(fmt) + 1;
+	char *s;
+
+	if (n < 0) return 0;
+	pf = malloc(sizeof *pf + n * sizeof *pf->dir + l);
+	if (!pf) return 0;
+	s = memcpy((char *)(pf->dir + n), fmt, l);
+	memset(pf->nl_type, 0, sizeof pf->nl_type);
+	pf->l10n = 0;
+	pf->n = compile(s, pf, pf->nl_type, &pf->l10n);
+	return pf;
+}
+
+static int printf_exec(FILE *f, const struct printf_format *pf, va_list *ap, union arg *nl_arg)
+{
+	unsigned fl;
+	int w, p, xp;
+	union arg arg;
+	int cnt=0, l;
+	size_t i;
+
+	for (i=0; i<pf->n; i++) {
+		const struct spec *sp = &pf->dir[i].sp;
+		if (!sp->st) {
+			l = pf->dir[i].l;
+			if (l > INT_MAX-cnt) goto overflow;
+			out(f, pf->dir[i].a, l);
+			cnt += l;
+			continue;
+		}
+
+		getargs(sp, &fl, &w, &p, &xp, &arg, ap, nl_arg);
+
+		/* Do not process any new directives once in error state. */
+		if (ferror(f)) return -1;
+
+		if ((l = fmt_spec(f, arg, fl, w, p, xp, sp->t, sp->ps, cnt)) < 0)
+			return -1;
+		if (l > INT_MAX-cnt) goto overflow;
+		cnt += l;
+	}
+	return cnt;
+
+overflow:
+	errno = EOVERFLOW;
+	return -1;
+}
+
+static int do_vfprintf(FILE *f, const char *fmt, const struct printf_format *pf, va_list *ap, union arg *nl_arg, int *nl_type)
+{
 	unsigned char internal_buf[80], *saved_buf = 0;
 	int olderr;
 	int ret;
 
-	/* the copy allows passing va_list* even if va_list is an array */
-	va_copy(ap2, ap);
-	if (printf_core(0, fmt, &ap2, nl_arg, nl_type) < 0) {
-		va_end(ap2);
-		return -1;
-	}
-
 	FLOCK(f);
 	olderr = f->flags & F_ERR;
 	f->flags &= ~F_ERR;
@@ -687,7 +863,8 @@ int vfprintf(FILE *restrict f, const char *restrict fmt, va_list ap)
 		f->wpos = f->wbase = f->wend = 0;
 	}
 	if (!f->wend && __towrite(f)) ret = -1;
-	else ret = printf_core(f, fmt, &ap2, nl_arg, nl_type);
+	else if (pf) ret = printf_exec(f, pf, ap, nl_arg);
+	else ret = printf_core(f, fmt, ap, nl_arg, nl_type);
 	if (saved_buf) {
 		f->write(f, 0, 0);
 		if (!f->wpos) ret = -1;
@@ -698,6 +875,41 @@ int vfprintf(FILE *restrict f, const char *restrict fmt, va_list ap)
 	if (ferror(f)) ret = -1;
 	f->flags |= olderr;
 	FUNLOCK(f);
+	return ret;
+}
+
+int vfprintf(FILE *restrict f, const char *restrict fmt, va_list ap)
+{
+	va_list ap2;
+	int nl_type[NL_ARGMAX+1] = {0};
+	union arg nl_arg[NL_ARGMAX+1];
+	int ret;
+
+	/* the copy allows passing va_list* even if va_list is an array */
+	va_copy(ap2, ap);
+	if (printf_core(0, fmt, &ap2, nl_arg, nl_type) < 0) {
+		va_end(ap2);
+		return -1;
+	}
+
+	ret = do_vfprintf(f, fmt, 0, &ap2, nl_arg, nl_type);
+	va_end(ap2);
+	return ret;
+}
+
+int vfprintf_compiled(FILE *restrict f, const struct printf_format *restrict pf, va_list ap)
+{
+	va_list ap2;
+	union arg nl_arg[NL_ARGMAX+1];
+	int ret, i;
+
+	/* The format was validated when it was compiled, so only the
+	 * positional arguments, if any, need to be fetched up front. */
+	va_copy(ap2, ap);
+	if (pf->l10n) for (i=1; i<=NL_ARGMAX && pf->nl_type[i]; i++)
+		pop_arg(nl_arg+i, pf->nl_type[i], &ap2);
+
+	ret = do_vfprintf(f, 0, pf, &ap2, nl_arg, 0);
 	va_end(ap2);
 	return ret;
 }
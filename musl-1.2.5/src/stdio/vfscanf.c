@@ -41,6 +41,24 @@ static void store_int(void *dest, int size, unsigned long long i)
 	}
 }
 
+/* Scan a decimal integer lying entirely within the buffer straight
+ * from rpos. Up to 19 digits cannot exceed ULLONG_MAX, so the result
+ * is exactly what __intscan would produce. */
+static int intscan_buf(FILE *f, unsigned long long *x)
+{
+	const unsigned char *s = f->rpos, *e = f->rend;
+	unsigned long long y = 0;
+	int neg = 0, n;
+
+	if (s<e && (*s=='+' || *s=='-')) neg = *s++=='-';
+	for (n=0; s<e && n<20 && *s-'0'<10U; s++, n++)
+		y = 10*y + *s-'0';
+	if (!n || n>19 || s==e) return 0;
+	f->rpos = (void *)s;
+	*x = neg ? -y : y;
+	return 1;
+}
+
 static void *arg_n(va_list ap, unsigned int n)
 {
 	void *p;
@@ -293,7 +311,8 @@ int vfscanf(FILE *restrict f, const char *restrict fmt, va_list ap)
 		case 'i':
 			base = 0;
 		int_common:
-			x = __intscan(f, base, 0, ULLONG_MAX);
+			if (base != 10 || width || !intscan_buf(f, &x))
+				x = __intscan(f, base, 0, ULLONG_MAX);
 			if (!shcnt(f)) goto match_fail;
 			if (t=='p' && dest) *(void **)dest = (void *)(uintptr_t)x;
 			else store_int(dest, size, x);
@@ -302,7 +321,8 @@ int vfscanf(FILE *restrict f, const char *restrict fmt, va_list ap)
 		case 'e': case 'E':
 		case 'f': case 'F':
 		case 'g': case 'G':
-			y = __floatscan(f, size, 0);
+			if (width || !__floatscan_buf(f, size, &y))
+				y = __floatscan(f, size, 0);
 			if (!shcnt(f)) goto match_fail;
 			if (dest) switch (size) {
 			case SIZE_def:
@@ -1,4 +1,5 @@
 #include "pthread_impl.h"
+#include <time.h>
 
 /* This lock primitive combines a flag (in the sign bit) and a
  * congestion count (= threads inside the critical section, CS) in a
@@ -16,14 +17,16 @@
  * with INT_MIN as a lock flag.
  */
 
-void __lock(volatile int *l)
+static volatile int dummy_int;
+weak_alias(dummy_int, __lockstat_on);
+
+static void dummy(volatile int *l, int contended, long long ns)
+{
+}
+weak_alias(dummy, __lockstat_record);
+
+static void lock_slow(volatile int *l, int current)
 {
-	int need_locks = libc.need_locks;
-	if (!need_locks) return;
-	/* fast path: INT_MIN for the lock, +1 for the congestion */
-	int current = a_cas(l, 0, INT_MIN + 1);
-	if (need_locks < 0) libc.need_locks = 0;
-	if (!current) return;
 	/* A first spin loop, for medium congestion. */
 	for (unsigned i = 0; i < 10; ++i) {
 		if (current < 0) current -= INT_MIN + 1;
@@ -51,6 +54,31 @@ void __lock(volatile int *l)
 	}
 }
 
+void __lock(volatile int *l)
+{
+	struct timespec t0, t1;
+	int need_locks = libc.need_locks;
+	if (!need_locks) return;
+	/* fast path: INT_MIN for the lock, +1 for the congestion */
+	int current = a_cas(l, 0, INT_MIN + 1);
+	if (need_locks < 0) libc.need_locks = 0;
+	if (!__lockstat_on) {
+		if (current) lock_slow(l, current);
+		return;
+	}
+	/* Statistics are recorded with the lock held, so the per-lock
+	 * counters need no further synchronization. */
+	if (!current) {
+		__lockstat_record(l, 0, 0);
+		return;
+	}
+	__clock_gettime(CLOCK_MONOTONIC, &t0);
+	lock_slow(l, current);
+	__clock_gettime(CLOCK_MONOTONIC, &t1);
+	__lockstat_record(l, 1, (t1.tv_sec - t0.tv_sec) * 1000000000LL
+		+ (t1.tv_nsec - t0.tv_nsec));
+}
+
 void __unlock(volatile int *l)
 {
 	/* Check l[0] to see if we are multi-threaded. */
@@ -0,0 +1,42 @@
+#include "pthread_impl.h"
+
+#define RSEQ_CPU_ID_REGISTRATION_FAILED -2
+#define RSEQ_FLAG_UNREGISTER 1
+#define RSEQ_FEATURE_SIZE 20
+
+#ifdef TLS_ABOVE_TP
+ptrdiff_t __rseq_offset = (ptrdiff_t)RSEQ_OFF
+	- (ptrdiff_t)(sizeof(struct pthread) + TP_OFFSET);
+#else
+ptrdiff_t __rseq_offset = RSEQ_OFF;
+#endif
+unsigned __rseq_size, __rseq_flags;
+
+int __rseq_register(pthread_t td)
+{
+	struct rseq_area *r = __rseq_area(td);
+	int ret = -ENOSYS;
+	r->cpu_id_start = 0;
+	r->rseq_cs = 0;
+	r->flags = 0;
+#if defined(RSEQ_SIG) && defined(SYS_rseq)
+	r->cpu_id = -1;
+	ret = __syscall(SYS_rseq, r, sizeof *r, 0, RSEQ_SIG);
+#endif
+	if (ret) {
+		r->cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+		return -1;
+	}
+	if (!__rseq_size) __rseq_size = RSEQ_FEATURE_SIZE;
+	return 0;
+}
+
+void __rseq_unregister(pthread_t td)
+{
+	struct rseq_area *r = __rseq_area(td);
+#if defined(RSEQ_SIG) && defined(SYS_rseq)
+	if (r->cpu_id >= 0)
+		__syscall(SYS_rseq, r, sizeof *r, RSEQ_FLAG_UNREGISTER, RSEQ_SIG);
+#endif
+	r->cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+}
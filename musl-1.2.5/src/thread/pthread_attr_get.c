@@ -96,3 +96,15 @@ int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t *restrict a, int *r
 	*pshared = a->__attr[0];
 	return 0;
 }
+
+int pthread_rwlockattr_getdistributed_np(const pthread_rwlockattr_t *restrict a, int *restrict distributed)
+{
+	*distributed = a->__attr[1] & 1;
+	return 0;
+}
+
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t *restrict a, int *restrict kind)
+{
+	*kind = a->__attr[1] >> 1 & 3;
+	return 0;
+}
@@ -4,6 +4,11 @@ int pthread_cond_broadcast(pthread_cond_t *c)
 {
 	if (!c->_c_shared) return __private_cond_signal(c, -1);
 	if (!c->_c_waiters) return 0;
+	/* Unlike the private case, process-shared waiters are not handed
+	 * to the mutex one at a time by requeueing. Each stays counted in
+	 * _c_waiters until its futex wait returns, and destroy waits for
+	 * that count to drain, so a waiter requeued onto a mutex held by
+	 * the destroying thread would never get there. */
 	a_inc(&c->_c_seq);
 	__wake(&c->_c_seq, -1, 0);
 	return 0;
@@ -3,6 +3,7 @@
 #include "stdio_impl.h"
 #include "libc.h"
 #include "lock.h"
+#include "fork_impl.h"
 #include <sys/mman.h>
 #include <string.h>
 #include <stddef.h>
@@ -149,6 +150,10 @@ _Noreturn void __pthread_exit(void *result)
 	self->prev->next = self->next;
 	self->prev = self->next = self;
 
+	/* The kernel writes to the rseq area until the thread exits, but
+	 * the area is about to be unmapped or handed back to a joiner. */
+	__rseq_unregister(self);
+
 	if (state==DT_DETACHED && self->map_base) {
 		/* Detached threads must block even implementation-internal
 		 * signals, since they will not have a stack in their last
@@ -203,6 +208,7 @@ static int start(void *p)
 			for (;;) __syscall(SYS_exit, 0);
 		}
 	}
+	__rseq_register(__pthread_self());
 	__syscall(SYS_rt_sigprocmask, SIG_SETMASK, &args->sig_mask, 0, _NSIG/8);
 	__pthread_exit(args->start_func(args->start_arg));
 	return 0;
@@ -212,12 +218,60 @@ static int start_c11(void *p)
 {
 	struct start_args *args = p;
 	int (*start)(void*) = (int(*)(void*)) args->start_func;
+	__rseq_register(__pthread_self());
 	__pthread_exit((void *)(uintptr_t)start(args->start_arg));
 	return 0;
 }
 
 #define ROUND(x) (((x)+PAGE_SIZE-1)&-PAGE_SIZE)
 
+/* Mappings of joined threads are kept for reuse by pthread_create,
+ * with their guard pages intact, rather than being unmapped. A mapping
+ * is only reused for a thread needing one of exactly the same size and
+ * guard size; the TLS and TSD areas are cleared before reuse. */
+
+#define STACK_CACHE_MAX 8
+
+static struct {
+	unsigned char *map;
+	size_t size, guard;
+} stack_cache[STACK_CACHE_MAX];
+static int stack_cache_cnt;
+static volatile int stack_cache_lock[1];
+volatile int *const __stack_cache_lockptr = stack_cache_lock;
+
+int __stack_cache_put(pthread_t t)
+{
+	int r = 0;
+	LOCK(stack_cache_lock);
+	if (stack_cache_cnt < STACK_CACHE_MAX) {
+		stack_cache[stack_cache_cnt].map = t->map_base;
+		stack_cache[stack_cache_cnt].size = t->map_size;
+		stack_cache[stack_cache_cnt].guard = t->guard_size;
+		stack_cache_cnt++;
+		r = 1;
+	}
+	UNLOCK(stack_cache_lock);
+	return r;
+}
+
+static unsigned char *stack_cache_get(size_t size, size_t guard)
+{
+	unsigned char *map = 0;
+	int i;
+	if (!stack_cache_cnt) return 0;
+	LOCK(stack_cache_lock);
+	for (i=stack_cache_cnt; i--; ) {
+		if (stack_cache[i].size == size && stack_cache[i].guard == guard) {
+			map = stack_cache[i].map;
+			stack_cache[i] = stack_cache[--stack_cache_cnt];
+			break;
+		}
+	}
+	UNLOCK(stack_cache_lock);
+	return map;
+}
+
 /* pthread_key_create.c overrides this */
 static volatile size_t dummy = 0;
 weak_alias(dummy, __pthread_tsd_size);
@@ -249,8 +303,10 @@ int __pthread_create(pthread_t *restrict res, const pthread_attr_t *restrict att
 	if (!libc.can_do_threads) return ENOSYS;
 	self = __pthread_self();
 	if (!libc.threaded) {
-		for (FILE *f=*__ofl_lock(); f; f=f->next)
-			init_file_lock(f);
+		FILE **ofl = __ofl_lock();
+		for (int i=0; i<OFL_SHARDS; i++)
+			for (FILE *f=ofl[i]; f; f=f->next)
+				init_file_lock(f);
 		__ofl_unlock();
 		init_file_lock(__stdin_used);
 		init_file_lock(__stdout_used);
@@ -291,7 +347,10 @@ int __pthread_create(pthread_t *restrict res, const pthread_attr_t *restrict att
 	}
 
 	if (!tsd) {
-		if (guard) {
+		if ((map = stack_cache_get(size, guard))) {
+			memset(map + size - __pthread_tsd_size - libc.tls_size,
+				0, libc.tls_size + __pthread_tsd_size);
+		} else if (guard) {
 			map = __mmap(0, size, PROT_NONE, MAP_PRIVATE|MAP_ANON, -1, 0);
 			if (map == MAP_FAILED) goto fail;
 			if (__mprotect(map+guard, size-guard, PROT_READ|PROT_WRITE)
@@ -0,0 +1,50 @@
+#define _GNU_SOURCE
+#include "pthread_impl.h"
+
+#define NSITES 128
+
+/* Statistics for libc internal locks, keyed by the address of the
+ * lock. Each lock is a distinct static object, so the address names
+ * the site and can be resolved with dladdr. Counters are only written
+ * by the thread holding the lock they belong to. */
+static struct lockstat_np sites[NSITES];
+
+volatile int __lockstat_on;
+
+void __lockstat_record(volatile int *l, int contended, long long ns)
+{
+	size_t i = ((uintptr_t)l >> 2) % NSITES, j;
+	struct lockstat_np *s;
+	const volatile void *k;
+
+	for (j=0; j<NSITES; j++, i=(i+1)%NSITES) {
+		s = sites+i;
+		k = s->lock;
+		if (!k) k = a_cas_p(&s->lock, 0, (void *)l);
+		if (!k || k == l) break;
+	}
+	if (j == NSITES) return;
+	s->acquired++;
+	if (contended) {
+		s->contended++;
+		s->wait_ns += ns;
+	}
+}
+
+int pthread_lockstat_enable_np(int on)
+{
+	int old = __lockstat_on;
+	a_store(&__lockstat_on, !!on);
+	return old;
+}
+
+size_t pthread_lockstat_np(struct lockstat_np *buf, size_t n)
+{
+	size_t i, cnt = 0;
+	for (i=0; i<NSITES; i++) {
+		if (!sites[i].lock) continue;
+		if (cnt < n) buf[cnt] = sites[i];
+		cnt++;
+	}
+	return cnt;
+}
@@ -1,8 +1,10 @@
+#define _GNU_SOURCE
 #include "pthread_impl.h"
 
 int __pthread_mutex_lock(pthread_mutex_t *m)
 {
-	if ((m->_m_type&15) == PTHREAD_MUTEX_NORMAL
+	int type = m->_m_type & 15;
+	if ((type == PTHREAD_MUTEX_NORMAL || type == PTHREAD_MUTEX_ADAPTIVE_NP)
 	    && !a_cas(&m->_m_lock, 0, EBUSY))
 		return 0;
 
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "pthread_impl.h"
 
 #define IS32BIT(x) !((x)+0x80000000ULL>>32)
@@ -53,22 +54,52 @@ static int pthread_mutex_timedlock_pi(pthread_mutex_t *restrict m, const struct
 	return e;
 }
 
+#define MAX_ADAPTIVE_SPINS 1000
+
+/* Spin for up to twice the number of iterations it recently took to
+ * get the lock, backing off exponentially between attempts to keep
+ * the cache line quiet while the owner finishes. Waiters already
+ * sleeping on the futex mean the lock is held too long for spinning
+ * to pay off. The estimate lives in _m_count, which the adaptive type
+ * does not otherwise use; updates are racy but it is only a hint. */
+static int adaptive_spin(pthread_mutex_t *m)
+{
+	int est = m->_m_count, max = 2*est + 10, cnt = 0, d = 1, i, r = EBUSY;
+
+	if (max > MAX_ADAPTIVE_SPINS) max = MAX_ADAPTIVE_SPINS;
+	while (cnt < max && !m->_m_waiters) {
+		if (!m->_m_lock && (r = __pthread_mutex_trylock(m)) != EBUSY)
+			break;
+		for (i=0; i<d; i++) a_spin();
+		cnt += d;
+		if (d < 64) d += d;
+	}
+	m->_m_count = est + (cnt - est)/8;
+	return r;
+}
+
 int __pthread_mutex_timedlock(pthread_mutex_t *restrict m, const struct timespec *restrict at)
 {
-	if ((m->_m_type&15) == PTHREAD_MUTEX_NORMAL
+	int type = m->_m_type & 15;
+	if ((type == PTHREAD_MUTEX_NORMAL || type == PTHREAD_MUTEX_ADAPTIVE_NP)
 	    && !a_cas(&m->_m_lock, 0, EBUSY))
 		return 0;
 
-	int type = m->_m_type;
+	type = m->_m_type;
 	int r, t, priv = (type & 128) ^ 128;
 
 	r = __pthread_mutex_trylock(m);
 	if (r != EBUSY) return r;
 
 	if (type&8) return pthread_mutex_timedlock_pi(m, at);
-	
-	int spins = 100;
-	while (spins-- && m->_m_lock && !m->_m_waiters) a_spin();
+
+	if ((type&3) == PTHREAD_MUTEX_ADAPTIVE_NP) {
+		r = adaptive_spin(m);
+		if (r != EBUSY) return r;
+	} else {
+		int spins = 100;
+		while (spins-- && m->_m_lock && !m->_m_waiters) a_spin();
+	}
 
 	while ((r=__pthread_mutex_trylock(m)) == EBUSY) {
 		r = m->_m_lock;
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "pthread_impl.h"
 
 int __pthread_mutex_unlock(pthread_mutex_t *m)
@@ -6,11 +7,12 @@ int __pthread_mutex_unlock(pthread_mutex_t *m)
 	int waiters = m->_m_waiters;
 	int cont;
 	int type = m->_m_type & 15;
+	int owned = type != PTHREAD_MUTEX_NORMAL && type != PTHREAD_MUTEX_ADAPTIVE_NP;
 	int priv = (m->_m_type & 128) ^ 128;
 	int new = 0;
 	int old;
 
-	if (type != PTHREAD_MUTEX_NORMAL) {
+	if (owned) {
 		self = __pthread_self();
 		old = m->_m_lock;
 		int own = old & 0x3fffffff;
@@ -40,7 +42,7 @@ int __pthread_mutex_unlock(pthread_mutex_t *m)
 	} else {
 		cont = a_swap(&m->_m_lock, new);
 	}
-	if (type != PTHREAD_MUTEX_NORMAL && !priv) {
+	if (owned && !priv) {
 		self->robust_list.pending = 0;
 		__vm_unlock();
 	}
@@ -1,8 +1,9 @@
+#define _GNU_SOURCE
 #include "pthread_impl.h"
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *a, int type)
 {
-	if ((unsigned)type > 2) return EINVAL;
+	if ((unsigned)type > PTHREAD_MUTEX_ADAPTIVE_NP) return EINVAL;
 	a->__attr = (a->__attr & ~3) | type;
 	return 0;
 }
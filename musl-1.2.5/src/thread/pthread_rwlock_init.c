@@ -1,8 +1,33 @@
 #include "pthread_impl.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_SLOTS 64
+
+static void init_slots(pthread_rwlock_t *rw)
+{
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	int n = 1;
+	void *p;
+
+	while (n < ncpu && n < MAX_SLOTS) n += n;
+	p = aligned_alloc(sizeof(struct rw_slot), n * sizeof(struct rw_slot));
+	if (!p) return;
+	memset(p, 0, n * sizeof(struct rw_slot));
+	rw->_rw_slots = p;
+	rw->_rw_mask = n-1;
+}
 
 int pthread_rwlock_init(pthread_rwlock_t *restrict rw, const pthread_rwlockattr_t *restrict a)
 {
 	*rw = (pthread_rwlock_t){0};
-	if (a) rw->_rw_shared = a->__attr[0]*128;
+	if (a) {
+		rw->_rw_shared = a->__attr[0]*128;
+		rw->_rw_kind = a->__attr[1] >> 1 & 3;
+		/* Without the slots the lock simply works as an ordinary
+		 * rwlock, so allocation failure is not an error. */
+		if ((a->__attr[1] & 1) && !a->__attr[0]) init_slots(rw);
+	}
 	return 0;
 }
@@ -11,7 +11,7 @@ int __pthread_rwlock_timedrdlock(pthread_rwlock_t *restrict rw, const struct tim
 	while (spins-- && rw->_rw_lock && !rw->_rw_waiters) a_spin();
 
 	while ((r=__pthread_rwlock_tryrdlock(rw))==EBUSY) {
-		if (!(r=rw->_rw_lock) || (r&0x7fffffff)!=0x7fffffff) continue;
+		if (!(r=rw->_rw_lock) || !(r&0x40000000)) continue;
 		t = r | 0x80000000;
 		a_inc(&rw->_rw_waiters);
 		a_cas(&rw->_rw_lock, r, t);
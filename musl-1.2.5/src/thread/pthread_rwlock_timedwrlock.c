@@ -1,8 +1,40 @@
+#define _GNU_SOURCE
 #include "pthread_impl.h"
 
+/* With the write lock word held, no new reader can get in; wait for
+ * the ones already counted in the slots to leave. */
+static int drain(pthread_rwlock_t *restrict rw, const struct timespec *restrict at)
+{
+	struct rw_slot *s = rw->_rw_slots;
+	int i, c, r;
+
+	for (i=0; i<=rw->_rw_mask; i++) {
+		while ((c = s[i].cnt)) {
+			a_inc(&s[i].waiters);
+			r = __timedwait(&s[i].cnt, c, CLOCK_REALTIME, at, 1);
+			a_dec(&s[i].waiters);
+			if (r && r != EINTR) return r;
+		}
+	}
+	return 0;
+}
+
+/* A writer giving up clears the hold on new readers unless another
+ * writer is still waiting behind it. */
+static void clear_pending(pthread_rwlock_t *rw)
+{
+	int val;
+	do {
+		val = rw->_rw_lock;
+		if (!(val & 0x40000000) || (val & 0x7fffffff) == 0x7fffffff)
+			return;
+	} while (a_cas(&rw->_rw_lock, val, val & ~0x40000000) != val);
+	if (rw->_rw_waiters) __wake(&rw->_rw_lock, -1, rw->_rw_shared^128);
+}
+
 int __pthread_rwlock_timedwrlock(pthread_rwlock_t *restrict rw, const struct timespec *restrict at)
 {
-	int r, t;
+	int r, t, pw;
 	
 	r = pthread_rwlock_trywrlock(rw);
 	if (r != EBUSY) return r;
@@ -10,15 +42,28 @@ int __pthread_rwlock_timedwrlock(pthread_rwlock_t *restrict rw, const struct tim
 	int spins = 100;
 	while (spins-- && rw->_rw_lock && !rw->_rw_waiters) a_spin();
 
-	while ((r=__pthread_rwlock_trywrlock(rw))==EBUSY) {
+	while ((r=a_cas(&rw->_rw_lock, 0, 0x7fffffff) ? EBUSY : 0)==EBUSY) {
 		if (!(r=rw->_rw_lock)) continue;
 		t = r | 0x80000000;
+		/* Hold back new readers until the current ones drain. */
+		pw = rw->_rw_kind == PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP;
+		if (pw) {
+			t |= 0x40000000;
+			a_inc(&rw->_rw_wwaiters);
+		}
 		a_inc(&rw->_rw_waiters);
 		a_cas(&rw->_rw_lock, r, t);
 		r = __timedwait(&rw->_rw_lock, t, CLOCK_REALTIME, at, rw->_rw_shared^128);
 		a_dec(&rw->_rw_waiters);
+		if (pw && a_fetch_add(&rw->_rw_wwaiters, -1)==1
+		    && r && r != EINTR)
+			clear_pending(rw);
 		if (r && r != EINTR) return r;
 	}
+	if (rw->_rw_slots) {
+		rw->_rw_owner = __pthread_self()->tid;
+		if ((r = drain(rw, at))) __pthread_rwlock_unlock(rw);
+	}
 	return r;
 }
 
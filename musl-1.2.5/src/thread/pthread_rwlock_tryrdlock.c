@@ -3,11 +3,22 @@
 int __pthread_rwlock_tryrdlock(pthread_rwlock_t *rw)
 {
 	int val, cnt;
+
+	if (rw->_rw_slots) {
+		struct rw_slot *s = __rw_slot(rw);
+		if (s->cnt >= 0x7ffffffe) return EAGAIN;
+		a_inc(&s->cnt);
+		if (!rw->_rw_lock) return 0;
+		if (a_fetch_add(&s->cnt, -1)==1 && s->waiters)
+			__wake(&s->cnt, 1, 1);
+		return EBUSY;
+	}
+
 	do {
 		val = rw->_rw_lock;
 		cnt = val & 0x7fffffff;
-		if (cnt == 0x7fffffff) return EBUSY;
-		if (cnt == 0x7ffffffe) return EAGAIN;
+		if (cnt & 0x40000000) return EBUSY;
+		if (cnt == 0x3ffffffe) return EAGAIN;
 	} while (a_cas(&rw->_rw_lock, val, val+1) != val);
 	return 0;
 }
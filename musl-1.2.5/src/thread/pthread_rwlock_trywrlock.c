@@ -3,6 +3,15 @@
 int __pthread_rwlock_trywrlock(pthread_rwlock_t *rw)
 {
 	if (a_cas(&rw->_rw_lock, 0, 0x7fffffff)) return EBUSY;
+	if (rw->_rw_slots) {
+		struct rw_slot *s = rw->_rw_slots;
+		int i;
+		rw->_rw_owner = __pthread_self()->tid;
+		for (i=0; i<=rw->_rw_mask; i++) if (s[i].cnt) {
+			__pthread_rwlock_unlock(rw);
+			return EBUSY;
+		}
+	}
 	return 0;
 }
 
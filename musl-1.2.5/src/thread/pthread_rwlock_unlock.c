@@ -4,11 +4,21 @@ int __pthread_rwlock_unlock(pthread_rwlock_t *rw)
 {
 	int val, cnt, waiters, new, priv = rw->_rw_shared^128;
 
+	if (rw->_rw_slots) {
+		if (rw->_rw_owner != __pthread_self()->tid) {
+			struct rw_slot *s = __rw_slot(rw);
+			if (a_fetch_add(&s->cnt, -1)==1 && s->waiters)
+				__wake(&s->cnt, 1, 1);
+			return 0;
+		}
+		rw->_rw_owner = 0;
+	}
+
 	do {
 		val = rw->_rw_lock;
 		cnt = val & 0x7fffffff;
 		waiters = rw->_rw_waiters;
-		new = (cnt == 0x7fffffff || cnt == 1) ? 0 : val-1;
+		new = (cnt == 0x7fffffff || (cnt & 0x3fffffff) == 1) ? 0 : val-1;
 	} while (a_cas(&rw->_rw_lock, val, new) != val);
 
 	if (!new && (waiters || val<0))
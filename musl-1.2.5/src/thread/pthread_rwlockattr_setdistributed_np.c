@@ -0,0 +1,9 @@
+#define _GNU_SOURCE
+#include "pthread_impl.h"
+
+int pthread_rwlockattr_setdistributed_np(pthread_rwlockattr_t *a, int distributed)
+{
+	if (distributed > 1U) return EINVAL;
+	a->__attr[1] = (a->__attr[1] & ~1) | distributed;
+	return 0;
+}
@@ -0,0 +1,10 @@
+#define _GNU_SOURCE
+#include "pthread_impl.h"
+
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t *a, int kind)
+{
+	if ((unsigned)kind > PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP)
+		return EINVAL;
+	a->__attr[1] = (a->__attr[1] & ~6) | kind<<1;
+	return 0;
+}
@@ -0,0 +1,26 @@
+#define _GNU_SOURCE
+#include <semaphore.h>
+#include <limits.h>
+#include "pthread_impl.h"
+
+int sem_post_multiple(sem_t *sem, unsigned n)
+{
+	int val, new, waiters, priv = sem->__val[2];
+	if (!n) return 0;
+	do {
+		val = sem->__val[0];
+		waiters = sem->__val[1];
+		if (n > SEM_VALUE_MAX - (val & SEM_VALUE_MAX)) {
+			errno = EOVERFLOW;
+			return -1;
+		}
+		new = val + n;
+		if (waiters <= n)
+			new &= ~0x80000000;
+	} while (a_cas(sem->__val, val, new) != val);
+	/* One wake for the whole batch: exactly n waiters if more are
+	 * queued than can proceed, otherwise all of them, matching the
+	 * flag being cleared above. */
+	if (val<0) __wake(sem->__val, waiters>n ? n : -1, priv);
+	return 0;
+}
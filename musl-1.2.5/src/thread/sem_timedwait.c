@@ -2,20 +2,39 @@
 #include <limits.h>
 #include "pthread_impl.h"
 
+#define MAX_SPINS 1000
+
 static void cleanup(void *p)
 {
 	a_dec(p);
 }
 
+/* Spin for up to twice the number of iterations a post recently took
+ * to arrive, with exponential backoff between polls. The estimate is
+ * kept in __val[3]; updates are racy but it is only a hint. */
+static int spin(sem_t *sem)
+{
+	int est = sem->__val[3], max = 2*est + 10, cnt = 0, d = 1, i, r = -1;
+
+	if (max > MAX_SPINS) max = MAX_SPINS;
+	while (cnt < max && !sem->__val[1]) {
+		if ((sem->__val[0] & SEM_VALUE_MAX) && !(r = sem_trywait(sem)))
+			break;
+		for (i=0; i<d; i++) a_spin();
+		cnt += d;
+		if (d < 64) d += d;
+	}
+	sem->__val[3] = est + (cnt - est)/8;
+	return r;
+}
+
 int sem_timedwait(sem_t *restrict sem, const struct timespec *restrict at)
 {
 	pthread_testcancel();
 
 	if (!sem_trywait(sem)) return 0;
 
-	int spins = 100;
-	while (spins-- && !(sem->__val[0] & SEM_VALUE_MAX) && !sem->__val[1])
-		a_spin();
+	if (!spin(sem)) return 0;
 
 	while (sem_trywait(sem)) {
 		int r, priv = sem->__val[2];
@@ -1,5 +1,4 @@
 #include "pthread_impl.h"
-#include <semaphore.h>
 #include <string.h>
 
 static void dummy_0(void)
@@ -9,34 +8,54 @@ static void dummy_0(void)
 weak_alias(dummy_0, __tl_lock);
 weak_alias(dummy_0, __tl_unlock);
 
-static int target_tid;
+static volatile int active, phase, caught, finished, exited;
 static void (*callback)(void *), *context;
-static sem_t target_sem, caller_sem, exit_sem;
 
 static void dummy(void *p)
 {
 }
 
+/* Each step of the handshake is a counter the caller waits on and
+ * every target bumps, so all threads advance in parallel rather than
+ * in a round trip per thread. */
+static void checkin(volatile int *cnt)
+{
+	a_inc(cnt);
+	__wake(cnt, 1, 1);
+}
+
+static void wait_count(volatile int *cnt, int n)
+{
+	int c;
+	while ((c = *cnt) < n) __futexwait(cnt, c, 1);
+}
+
+static void wait_phase(int p)
+{
+	int c;
+	while ((c = phase) < p) __futexwait(&phase, c, 1);
+}
+
 static void handler(int sig)
 {
-	if (__pthread_self()->tid != target_tid) return;
+	if (!active) return;
 
 	int old_errno = errno;
 
 	/* Inform caller we have received signal and wait for
 	 * the caller to let us make the callback. */
-	sem_post(&caller_sem);
-	sem_wait(&target_sem);
+	checkin(&caught);
+	wait_phase(1);
 
 	callback(context);
 
-	/* Inform caller we've complered the callback and wait
+	/* Inform caller we've completed the callback and wait
 	 * for the caller to release us to return. */
-	sem_post(&caller_sem);
-	sem_wait(&exit_sem);
+	checkin(&finished);
+	wait_phase(2);
 
 	/* Inform caller we are returning and state is destroyable. */
-	sem_post(&caller_sem);
+	checkin(&exited);
 
 	errno = old_errno;
 }
@@ -44,7 +63,7 @@ static void handler(int sig)
 void __synccall(void (*func)(void *), void *ctx)
 {
 	sigset_t oldmask;
-	int cs, i, r;
+	int cs, r;
 	struct sigaction sa = { .sa_flags = SA_RESTART | SA_ONSTACK, .sa_handler = handler };
 	pthread_t self = __pthread_self(), td;
 	int count = 0;
@@ -60,9 +79,7 @@ void __synccall(void (*func)(void *), void *ctx)
 	__block_all_sigs(0);
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cs);
 
-	sem_init(&target_sem, 0, 0);
-	sem_init(&caller_sem, 0, 0);
-	sem_init(&exit_sem, 0, 0);
+	phase = caught = finished = exited = 0;
 
 	if (!libc.threads_minus_1 || __syscall(SYS_gettid) != self->tid)
 		goto single_threaded;
@@ -76,45 +93,43 @@ void __synccall(void (*func)(void *), void *ctx)
 	memset(&sa.sa_mask, -1, sizeof sa.sa_mask);
 	__libc_sigaction(SIGSYNCCALL, &sa, 0);
 
-
+	/* Signal all threads at once; the thread list lock keeps the
+	 * set of threads fixed, so each gets exactly one signal. */
+	active = 1;
 	for (td=self->next; td!=self; td=td->next) {
-		target_tid = td->tid;
 		while ((r = -__syscall(SYS_tkill, td->tid, SIGSYNCCALL)) == EAGAIN);
 		if (r) {
 			/* If we failed to signal any thread, nop out the
 			 * callback to abort the synccall and just release
-			 * any threads already caught. */
+			 * any threads already signaled. */
 			callback = func = dummy;
 			break;
 		}
-		sem_wait(&caller_sem);
 		count++;
 	}
-	target_tid = 0;
-
-	/* Serialize execution of callback in caught threads, or just
-	 * release them all if synccall is being aborted. */
-	for (i=0; i<count; i++) {
-		sem_post(&target_sem);
-		sem_wait(&caller_sem);
-	}
+	wait_count(&caught, count);
+	active = 0;
 
 	sa.sa_handler = SIG_IGN;
 	__libc_sigaction(SIGSYNCCALL, &sa, 0);
 
 single_threaded:
+	/* The callback runs in the caller alone first, so that it can
+	 * record failure for the other threads to see, then in all the
+	 * caught threads concurrently. */
 	func(ctx);
-
-	/* Only release the caught threads once all threads, including the
-	 * caller, have returned from the callback function. */
-	for (i=0; i<count; i++)
-		sem_post(&exit_sem);
-	for (i=0; i<count; i++)
-		sem_wait(&caller_sem);
-
-	sem_destroy(&caller_sem);
-	sem_destroy(&target_sem);
-	sem_destroy(&exit_sem);
+	if (count) {
+		a_store(&phase, 1);
+		__wake(&phase, -1, 1);
+		wait_count(&finished, count);
+
+		/* Only release the caught threads once all threads,
+		 * including the caller, have returned from the callback
+		 * function. */
+		a_store(&phase, 2);
+		__wake(&phase, -1, 1);
+		wait_count(&exited, count);
+	}
 
 	pthread_setcancelstate(cs, 0);
 	__tl_unlock();